@@ -0,0 +1,202 @@
+#include <charconv>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Arena.h"
+#include "Lox.h"
+#include "Parser.h"
+#include "Resolver.h"
+#include "Scanner.h"
+
+using namespace lox;
+using std::string;
+using std::vector;
+
+// Times the Scanner, Parser and Resolver separately on generated sources and reports MB/s and tokens/s.
+//
+// usage: lox_frontend_bench [--min-size=bytes] [--max-size=bytes] [--json]
+// sizes grow by 8x from min and the sweep always ends with max: 1KB, 8KB, 64KB, 512KB, 4MB and 16MB by default.
+// --max-size=104857600 extends the sweep to a 100MB source, which takes about 10GB of memory: the tokens and the AST
+// of a source are kept alive together, at roughly 100 bytes per source byte.
+
+struct SourceKind
+{
+    string mName;
+    // appends one top level chunk of code, i is a counter to keep names unique
+    std::function<void(std::ostringstream &, size_t i)> mAppend;
+};
+
+static void AppendNestedExpression(std::ostringstream &ss, size_t i)
+{
+    // nesting is kept well below what the recursive descent parser can handle
+    const int depth = 40;
+    ss << "var e" << i << " = ";
+    for (int d = 0; d < depth; d++)
+        ss << "(" << d << " + -";
+    ss << "e" << (i ? i - 1 : 0);
+    for (int d = 0; d < depth; d++)
+        ss << (d % 2 ? " * 2)" : " or nil)");
+    ss << ";\n";
+}
+
+static void AppendSmallFunction(std::ostringstream &ss, size_t i)
+{
+    ss << "fun f" << i << "(a, b) {\n"
+       << "  var c = a * b;\n"
+       << "  if (c > 10) return c - a; else return f" << (i ? i - 1 : 0) << "(b, c);\n"
+       << "}\n";
+}
+
+static void AppendLargeClass(std::ostringstream &ss, size_t i)
+{
+    ss << "class C" << i << (i ? " < C" + std::to_string(i - 1) : "") << " {\n";
+    ss << "  init(x) {\n";
+    for (int f = 0; f < 16; f++)
+        ss << "    this.field" << f << " = x + " << f << ";\n";
+    ss << "  }\n";
+    for (int m = 0; m < 16; m++)
+        ss << "  method" << m << "(y) { return this.field" << m << " + y; }\n";
+    if (i)
+        ss << "  sum() { return super.method0(1) + this.method1(2); }\n";
+    ss << "}\n";
+}
+
+static string Generate(const SourceKind &kind, size_t size)
+{
+    std::ostringstream ss;
+    for (size_t i = 0; static_cast<size_t>(ss.tellp()) < size; i++)
+        kind.mAppend(ss, i);
+    return ss.str();
+}
+
+// grows by 8x from min, the last size is max itself so that the sweep covers it
+static vector<size_t> Sizes(size_t minSize, size_t maxSize)
+{
+    vector<size_t> sizes;
+    for (size_t size = minSize; size < maxSize; size *= 8)
+        sizes.push_back(size);
+    sizes.push_back(maxSize);
+    return sizes;
+}
+
+// the number of bytes text spells, 0 if it is not a number
+static size_t ParseSize(const string &text)
+{
+    size_t size;
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), size);
+    if (error != std::errc() || end != text.data() + text.size())
+        return 0;
+    return size;
+}
+
+template <typename F> static double Time(const F &f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+int main(int argc, char const *argv[])
+{
+    size_t minSize = 1024;
+    size_t maxSize = 16 * 1024 * 1024;
+    bool json = false;
+
+    for (int argi = 1; argi < argc; argi++)
+    {
+        string arg(argv[argi]);
+        if (arg.starts_with("--min-size=") && ParseSize(arg.substr(11)) > 0)
+            minSize = ParseSize(arg.substr(11));
+        else if (arg.starts_with("--max-size=") && ParseSize(arg.substr(11)) > 0)
+            maxSize = ParseSize(arg.substr(11));
+        else if (arg == "--json")
+            json = true;
+        else
+        {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 64;
+        }
+    }
+    if (minSize > maxSize)
+    {
+        std::cerr << "Invalid sizes: --min-size=" << minSize << " exceeds --max-size=" << maxSize << std::endl;
+        return 64;
+    }
+
+    const vector<SourceKind> kinds = {
+        {"nested_expressions", AppendNestedExpression},
+        {"small_functions", AppendSmallFunction},
+        {"large_classes", AppendLargeClass},
+    };
+
+    if (json)
+        std::cout << "[" << std::endl;
+    else
+        std::cout << std::left << std::setw(20) << "source" << std::right << std::setw(12) << "bytes" << std::setw(12)
+                  << "tokens" << std::setw(12) << "scan MB/s" << std::setw(14) << "scan tok/s" << std::setw(12)
+                  << "parse MB/s" << std::setw(14) << "parse tok/s" << std::setw(14) << "resolve MB/s" << std::setw(16)
+                  << "resolve tok/s" << std::endl;
+
+    bool first = true;
+    for (auto &kind : kinds)
+    {
+        for (auto size : Sizes(minSize, maxSize))
+        {
+            auto source = Generate(kind, size);
+
+            Arena arena;
+            Scanner scanner(source, arena);
+            const vector<Token *> *tokens;
+            auto scanSeconds = Time([&] { tokens = &scanner.ScanTokens(); });
+
+            Parser parser(*tokens, arena);
+            vector<Stmt *> stmts;
+            auto parseSeconds = Time([&] { stmts = parser.Parse(); });
+
+            Resolver resolver;
+            auto resolveSeconds = Time([&] { resolver.Resolve(stmts); });
+
+            if (Lox::HadError())
+            {
+                std::cerr << kind.mName << " produced an invalid source" << std::endl;
+                return 70;
+            }
+
+            double mb = source.size() / (1024.0 * 1024.0);
+            double count = tokens->size();
+            if (json)
+            {
+                std::cout << (first ? "" : ",\n") << "  {\"source\": \"" << kind.mName
+                          << "\", \"bytes\": " << source.size() << ", \"tokens\": " << tokens->size()
+                          << ", \"scan_seconds\": " << scanSeconds << ", \"parse_seconds\": " << parseSeconds
+                          << ", \"resolve_seconds\": " << resolveSeconds << ", \"scan_mb_per_s\": " << mb / scanSeconds
+                          << ", \"scan_tokens_per_s\": " << count / scanSeconds
+                          << ", \"parse_mb_per_s\": " << mb / parseSeconds
+                          << ", \"parse_tokens_per_s\": " << count / parseSeconds
+                          << ", \"resolve_mb_per_s\": " << mb / resolveSeconds
+                          << ", \"resolve_tokens_per_s\": " << count / resolveSeconds << "}";
+                first = false;
+            }
+            else
+            {
+                std::cout << std::left << std::setw(20) << kind.mName << std::right << std::setw(12) << source.size()
+                          << std::setw(12) << tokens->size() << std::fixed << std::setprecision(2) << std::setw(12)
+                          << mb / scanSeconds << std::setw(14) << std::setprecision(0) << count / scanSeconds
+                          << std::setw(12) << std::setprecision(2) << mb / parseSeconds << std::setw(14)
+                          << std::setprecision(0) << count / parseSeconds << std::setw(14) << std::setprecision(2)
+                          << mb / resolveSeconds << std::setw(16) << std::setprecision(0) << count / resolveSeconds
+                          << std::endl;
+            }
+        }
+    }
+    if (json)
+        std::cout << std::endl << "]" << std::endl;
+
+    return 0;
+}
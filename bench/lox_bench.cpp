@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "Lox.h"
+
+using namespace lox;
+using std::string;
+using std::vector;
+
+// Runs the Lox benchmark programs through Lox::RunFile and reports wall time, allocations and peak RSS.
+//
+// usage: lox_bench [--engine=tree|vm|all] [--warmup=n] [--repetitions=n] [--scripts=dir] [--json] [name...]
+
+static const vector<string> sBenchmarks = {
+    "fib",             "binary_trees", "method_call", "properties",     "instantiation", "equality",
+    "string_equality", "trees",        "zoo",         "deep_recursion", "aggregation",   "string_building",
+};
+
+struct BenchResult
+{
+    string mName;
+    string mEngine;
+    vector<double> mSeconds;
+    GcStats mGcStats;
+    long mPeakRssKb = 0;
+};
+
+static bool ParseOption(const string &arg, const string &name, string &value)
+{
+    if (!arg.starts_with(name + "="))
+        return false;
+    value = arg.substr(name.size() + 1);
+    return true;
+}
+
+// the count text spells, -1 if it is not a number or negative
+static int ParseCount(const string &text)
+{
+    int count;
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), count);
+    if (error != std::errc() || end != text.data() + text.size() || count < 0)
+        return -1;
+    return count;
+}
+
+// Linux resets the VmHWM high-water mark when "5" is written to clear_refs, which lets every run measure its own
+// peak. Where that is not supported the peak of the whole process so far is reported.
+static void ResetPeakRss()
+{
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    if (clearRefs)
+        clearRefs << "5";
+}
+
+static long PeakRssKb()
+{
+    std::ifstream status("/proc/self/status");
+    string line;
+    while (std::getline(status, line))
+    {
+        if (line.starts_with("VmHWM:"))
+            return std::stol(line.substr(6));
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static double Median(vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    auto mid = values.size() / 2;
+    return values.size() % 2 ? values[mid] : (values[mid - 1] + values[mid]) / 2;
+}
+
+static bool Run(const string &path, Engine engine, double &seconds)
+{
+    std::ostringstream out;
+    Lox::ResetError();
+
+    auto start = std::chrono::steady_clock::now();
+    Lox::RunFile(path, out, engine);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    seconds = elapsed.count();
+    return !Lox::HadError();
+}
+
+static void PrintText(const vector<BenchResult> &results)
+{
+    std::cout << std::left << std::setw(18) << "benchmark" << std::setw(6) << "engine" << std::right
+              << std::setw(10) << "min(s)" << std::setw(10) << "median(s)" << std::setw(12) << "objects"
+              << std::setw(14) << "bytes" << std::setw(14) << "peak rss(KB)" << std::endl;
+
+    for (auto &result : results)
+    {
+        std::cout << std::left << std::setw(18) << result.mName << std::setw(6) << result.mEngine << std::right
+                  << std::fixed << std::setprecision(4) << std::setw(10)
+                  << *std::min_element(result.mSeconds.begin(), result.mSeconds.end()) << std::setw(10)
+                  << Median(result.mSeconds) << std::setw(12) << result.mGcStats.mObjectsAllocated << std::setw(14)
+                  << result.mGcStats.mBytesAllocated << std::setw(14) << result.mPeakRssKb << std::endl;
+    }
+}
+
+static void PrintJson(const vector<BenchResult> &results)
+{
+    std::cout << "[" << std::endl;
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        auto &result = results[i];
+        std::cout << "  {\"name\": \"" << result.mName << "\", \"engine\": \"" << result.mEngine
+                  << "\", \"seconds\": [";
+        for (size_t j = 0; j < result.mSeconds.size(); j++)
+            std::cout << (j ? ", " : "") << std::setprecision(6) << result.mSeconds[j];
+        std::cout << "], \"min_seconds\": " << *std::min_element(result.mSeconds.begin(), result.mSeconds.end())
+                  << ", \"median_seconds\": " << Median(result.mSeconds)
+                  << ", \"objects_allocated\": " << result.mGcStats.mObjectsAllocated
+                  << ", \"bytes_allocated\": " << result.mGcStats.mBytesAllocated
+                  << ", \"gc_collections\": " << result.mGcStats.mCollections
+                  << ", \"gc_peak_bytes\": " << result.mGcStats.mPeakBytes
+                  << ", \"peak_rss_kb\": " << result.mPeakRssKb << "}" << (i + 1 < results.size() ? "," : "")
+                  << std::endl;
+    }
+    std::cout << "]" << std::endl;
+}
+
+int main(int argc, char const *argv[])
+{
+    vector<std::pair<Engine, string>> engines = {{ENGINE_TREE_WALKER, "tree"}, {ENGINE_VM, "vm"}};
+    int warmup = 1;
+    int repetitions = 5;
+    string scriptDir = LOX_BENCH_SCRIPT_DIR;
+    bool json = false;
+    vector<string> names;
+
+    for (int argi = 1; argi < argc; argi++)
+    {
+        string arg(argv[argi]);
+        string value;
+        if (!arg.starts_with("--"))
+            names.push_back(arg);
+        else if (ParseOption(arg, "--engine", value) && (value == "tree" || value == "vm" || value == "all"))
+        {
+            if (value != "all")
+                engines = {value == "vm" ? engines[1] : engines[0]};
+        }
+        else if (ParseOption(arg, "--warmup", value) && ParseCount(value) >= 0)
+            warmup = ParseCount(value);
+        else if (ParseOption(arg, "--repetitions", value) && ParseCount(value) > 0)
+            repetitions = ParseCount(value);
+        else if (ParseOption(arg, "--scripts", value))
+            scriptDir = value;
+        else if (arg == "--json")
+            json = true;
+        else
+        {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 64;
+        }
+    }
+    if (names.empty())
+        names = sBenchmarks;
+
+    vector<BenchResult> results;
+    for (auto &name : names)
+    {
+        string path = scriptDir + "/" + name + ".lox";
+        if (!std::ifstream(path))
+        {
+            std::cerr << "No such benchmark: " << path << std::endl;
+            return 66;
+        }
+
+        for (auto &[engine, engineName] : engines)
+        {
+            BenchResult result{name, engineName};
+            double seconds;
+            for (int i = 0; i < warmup; i++)
+            {
+                if (!Run(path, engine, seconds))
+                {
+                    std::cerr << name << " failed on " << engineName << std::endl;
+                    return 70;
+                }
+            }
+
+            for (int i = 0; i < repetitions; i++)
+            {
+                ResetPeakRss();
+                if (!Run(path, engine, seconds))
+                {
+                    std::cerr << name << " failed on " << engineName << std::endl;
+                    return 70;
+                }
+                result.mSeconds.push_back(seconds);
+                result.mPeakRssKb = std::max(result.mPeakRssKb, PeakRssKb());
+            }
+            result.mGcStats = Lox::LastGcStats();
+            results.push_back(result);
+        }
+    }
+
+    if (json)
+        PrintJson(results);
+    else
+        PrintText(results);
+    return 0;
+}
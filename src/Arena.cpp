@@ -0,0 +1,39 @@
+#include "Arena.h"
+
+#include <cstdint>
+
+namespace lox
+{
+
+void *Arena::Allocate(size_t size, size_t align)
+{
+    auto address = reinterpret_cast<uintptr_t>(mCursor);
+    auto aligned = (address + align - 1) & ~(uintptr_t)(align - 1);
+    if (!mCursor || aligned + size > reinterpret_cast<uintptr_t>(mLimit))
+    {
+        // oversized requests get a block of their own
+        auto blockSize = size + align > BLOCK_SIZE ? size + align : BLOCK_SIZE;
+        mBlocks.emplace_back(new std::byte[blockSize]);
+        mCursor = mBlocks.back().get();
+        mLimit = mCursor + blockSize;
+        address = reinterpret_cast<uintptr_t>(mCursor);
+        aligned = (address + align - 1) & ~(uintptr_t)(align - 1);
+    }
+
+    mCursor = reinterpret_cast<std::byte *>(aligned + size);
+    mBytes += size;
+    return reinterpret_cast<void *>(aligned);
+}
+
+void Arena::Release()
+{
+    for (auto it = mDestructors.rbegin(); it != mDestructors.rend(); it++)
+        it->mDestroy(it->mObject);
+    mDestructors.clear();
+    mBlocks.clear();
+    mCursor = nullptr;
+    mLimit = nullptr;
+    mBytes = 0;
+}
+
+} // namespace lox
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace lox
+{
+
+using std::vector;
+
+// Bump allocator owning the tokens and AST nodes of one compilation.
+// Objects are carved out of large blocks and never freed one by one; Release destroys all of them at once.
+// Nodes reference each other with raw pointers, which stay valid as long as the arena does.
+class Arena
+{
+  public:
+    Arena()
+    {
+    }
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+    ~Arena()
+    {
+        Release();
+    }
+
+    template <typename T, typename... Args> T *New(Args &&...args)
+    {
+        auto object = new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        if constexpr (!std::is_trivially_destructible_v<T>)
+            mDestructors.push_back({object, [](void *p) { static_cast<T *>(p)->~T(); }});
+        return object;
+    }
+
+    void *Allocate(size_t size, size_t align);
+    // destroys every object and gives the blocks back
+    void Release();
+
+    size_t Bytes() const
+    {
+        return mBytes;
+    }
+
+  private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    struct Destructor
+    {
+        void *mObject;
+        void (*mDestroy)(void *);
+    };
+
+    vector<std::unique_ptr<std::byte[]>> mBlocks;
+    vector<Destructor> mDestructors;
+    std::byte *mCursor = nullptr;
+    std::byte *mLimit = nullptr;
+    size_t mBytes = 0;
+};
+
+} // namespace lox
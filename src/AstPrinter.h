@@ -32,11 +32,11 @@ class AstPrinter : public Expr::Visitor<string>, public Stmt::Visitor<string>
 
     virtual string Visit(const Expression &stmt) override
     {
-        return Parenthesize(";", vector<shared_ptr<Expr>>{stmt.mExpression});
+        return Parenthesize(";", vector<Expr *>{stmt.mExpression});
     }
     virtual string Visit(const Print &stmt) override
     {
-        return Parenthesize("print", vector<shared_ptr<Expr>>{stmt.mExpression});
+        return Parenthesize("print", vector<Expr *>{stmt.mExpression});
     }
     virtual string Visit(const Var &stmt) override
     {
@@ -89,7 +89,7 @@ class AstPrinter : public Expr::Visitor<string>, public Stmt::Visitor<string>
     {
         if (!stmt.mValue)
             return "(return)";
-        return Parenthesize("return", vector<shared_ptr<Expr>>{stmt.mValue});
+        return Parenthesize("return", vector<Expr *>{stmt.mValue});
     }
     virtual string Visit(const Class &stmt) override
     {
@@ -110,7 +110,7 @@ class AstPrinter : public Expr::Visitor<string>, public Stmt::Visitor<string>
 
     virtual string Visit(const Binary &expr) override
     {
-        return Parenthesize(expr.mOp->Lexeme(), vector<shared_ptr<Expr>>{expr.mLeft, expr.mRight});
+        return Parenthesize(expr.mOp->Lexeme(), vector<Expr *>{expr.mLeft, expr.mRight});
     }
 
     virtual string Visit(const Call &expr) override
@@ -125,7 +125,17 @@ class AstPrinter : public Expr::Visitor<string>, public Stmt::Visitor<string>
 
     virtual string Visit(const Grouping &expr) override
     {
-        return Parenthesize("group", vector<shared_ptr<Expr>>{expr.mExpression});
+        return Parenthesize("group", vector<Expr *>{expr.mExpression});
+    }
+
+    virtual string Visit(const Index &expr) override
+    {
+        return Parenthesize("[]", vector<Expr *>{expr.mObject, expr.mIndex});
+    }
+
+    virtual string Visit(const ListLiteral &expr) override
+    {
+        return Parenthesize("list", expr.mElements);
     }
 
     virtual string Visit(const Literal &expr) override
@@ -135,7 +145,18 @@ class AstPrinter : public Expr::Visitor<string>, public Stmt::Visitor<string>
 
     virtual string Visit(const Logical &expr) override
     {
-        return Parenthesize(expr.mOp->Lexeme(), vector<shared_ptr<Expr>>{expr.mLeft, expr.mRight});
+        return Parenthesize(expr.mOp->Lexeme(), vector<Expr *>{expr.mLeft, expr.mRight});
+    }
+
+    virtual string Visit(const MapLiteral &expr) override
+    {
+        vector<Expr *> entries;
+        for (size_t i = 0; i < expr.mKeys.size(); i++)
+        {
+            entries.push_back(expr.mKeys[i]);
+            entries.push_back(expr.mValues[i]);
+        }
+        return Parenthesize("map", entries);
     }
 
     virtual string Visit(const Set &expr) override
@@ -143,6 +164,11 @@ class AstPrinter : public Expr::Visitor<string>, public Stmt::Visitor<string>
         return Parenthesize2("=", vector<any>{expr.mObject, expr.mName->Lexeme(), expr.mValue});
     }
 
+    virtual string Visit(const SetIndex &expr) override
+    {
+        return Parenthesize("[]=", vector<Expr *>{expr.mObject, expr.mIndex, expr.mValue});
+    }
+
     virtual string Visit(const Super &expr) override
     {
         return Parenthesize2("super", vector<any>{expr.mMethod});
@@ -155,7 +181,7 @@ class AstPrinter : public Expr::Visitor<string>, public Stmt::Visitor<string>
 
     virtual string Visit(const Unary &expr) override
     {
-        return Parenthesize(expr.mOp->Lexeme(), vector<shared_ptr<Expr>>{expr.mRight});
+        return Parenthesize(expr.mOp->Lexeme(), vector<Expr *>{expr.mRight});
     }
 
     virtual string Visit(const Variable &expr) override
@@ -164,7 +190,7 @@ class AstPrinter : public Expr::Visitor<string>, public Stmt::Visitor<string>
     }
 
   private:
-    string Parenthesize(const string &name, const vector<shared_ptr<Expr>> &exprs)
+    string Parenthesize(const string &name, const vector<Expr *> &exprs)
     {
         stringstream ss;
 
@@ -199,17 +225,17 @@ class AstPrinter : public Expr::Visitor<string>, public Stmt::Visitor<string>
             {
                 ss << any_cast<string>(part);
             }
-            else if (IsType<shared_ptr<Expr>>(part))
+            else if (IsType<Expr *>(part))
             {
-                ss << any_cast<shared_ptr<Expr>>(part)->Accept(*this);
+                ss << any_cast<Expr *>(part)->Accept(*this);
             }
-            else if (IsType<shared_ptr<Token>>(part))
+            else if (IsType<Token *>(part))
             {
-                ss << any_cast<shared_ptr<Token>>(part)->Lexeme();
+                ss << any_cast<Token *>(part)->Lexeme();
             }
-            else if (IsType<vector<shared_ptr<Expr>>>(part))
+            else if (IsType<vector<Expr *>>(part))
             {
-                Transform(ss, ToAnyVector(any_cast<vector<shared_ptr<Expr>>>(part)));
+                Transform(ss, ToAnyVector(any_cast<vector<Expr *>>(part)));
             }
             else
             {
@@ -0,0 +1,328 @@
+#include "Chunk.h"
+#include "VmObject.h"
+
+#include <iomanip>
+
+namespace lox
+{
+
+void Chunk::Write(uint8_t byte, int line)
+{
+    if (mLines.empty() || mLines.back().mLine != line)
+        mLines.push_back(LineStart{mCode.size(), line});
+    mCode.push_back(byte);
+}
+
+size_t Chunk::AddConstant(const Value &value)
+{
+    mConstants.push_back(value);
+    return mConstants.size() - 1;
+}
+
+int Chunk::GetLine(size_t offset) const
+{
+    size_t start = 0;
+    size_t end = mLines.size();
+    while (end - start > 1)
+    {
+        size_t mid = (start + end) / 2;
+        if (mLines.at(mid).mOffset <= offset)
+            start = mid;
+        else
+            end = mid;
+    }
+    return mLines.empty() ? 0 : mLines.at(start).mLine;
+}
+
+void Chunk::Disassemble(std::ostream &os, const string &name) const
+{
+    os << "== " << name << " ==" << std::endl;
+    for (size_t offset = 0; offset < mCode.size();)
+        offset = DisassembleInstruction(os, offset);
+
+    for (auto &constant : mConstants)
+    {
+        if (constant.IsObj() && constant.AsObj()->Kind() == OBJ_KIND_VM_FUNCTION)
+        {
+            auto &function = static_cast<VmFunction &>(*constant.AsObj());
+            function.GetChunk().Disassemble(os, function.Str());
+        }
+    }
+}
+
+static size_t SimpleInstruction(std::ostream &os, const char *name, size_t offset)
+{
+    os << name << std::endl;
+    return offset + 1;
+}
+
+static size_t ByteInstruction(std::ostream &os, const char *name, const vector<uint8_t> &code, size_t offset)
+{
+    os << std::left << std::setw(16) << name << " " << static_cast<int>(code.at(offset + 1)) << std::endl;
+    return offset + 2;
+}
+
+static uint16_t ReadShort(const vector<uint8_t> &code, size_t offset)
+{
+    return static_cast<uint16_t>((code.at(offset) << 8) | code.at(offset + 1));
+}
+
+static size_t JumpInstruction(std::ostream &os, const char *name, int sign, const vector<uint8_t> &code,
+                              size_t offset)
+{
+    auto jump = ReadShort(code, offset + 1);
+    os << std::left << std::setw(16) << name << " " << offset << " -> " << (offset + 3 + sign * jump) << std::endl;
+    return offset + 3;
+}
+
+size_t Chunk::DisassembleInstruction(std::ostream &os, size_t offset) const
+{
+    os << std::setfill('0') << std::right << std::setw(4) << offset << std::setfill(' ') << " ";
+    if (offset > 0 && GetLine(offset) == GetLine(offset - 1))
+        os << "   | ";
+    else
+        os << std::setw(4) << GetLine(offset) << " ";
+
+    auto constantInstruction = [&](const char *name) {
+        auto constant = ReadShort(mCode, offset + 1);
+        os << std::left << std::setw(16) << name << " " << constant << " '" << mConstants.at(constant).Str() << "'"
+           << std::endl;
+        return offset + 3;
+    };
+    auto shortInstruction = [&](const char *name) {
+        os << std::left << std::setw(16) << name << " " << ReadShort(mCode, offset + 1) << std::endl;
+        return offset + 3;
+    };
+    auto invokeInstruction = [&](const char *name) {
+        auto constant = ReadShort(mCode, offset + 1);
+        os << std::left << std::setw(16) << name << " (" << static_cast<int>(mCode.at(offset + 3)) << " args) "
+           << constant << " '" << mConstants.at(constant).Str() << "'" << std::endl;
+        return offset + 4;
+    };
+
+    switch (mCode.at(offset))
+    {
+    case OP_CONSTANT:
+        return constantInstruction("OP_CONSTANT");
+    case OP_NIL:
+        return SimpleInstruction(os, "OP_NIL", offset);
+    case OP_TRUE:
+        return SimpleInstruction(os, "OP_TRUE", offset);
+    case OP_FALSE:
+        return SimpleInstruction(os, "OP_FALSE", offset);
+    case OP_POP:
+        return SimpleInstruction(os, "OP_POP", offset);
+    case OP_GET_LOCAL:
+        return ByteInstruction(os, "OP_GET_LOCAL", mCode, offset);
+    case OP_SET_LOCAL:
+        return ByteInstruction(os, "OP_SET_LOCAL", mCode, offset);
+    case OP_GET_GLOBAL:
+        return shortInstruction("OP_GET_GLOBAL");
+    case OP_DEFINE_GLOBAL:
+        return shortInstruction("OP_DEFINE_GLOBAL");
+    case OP_SET_GLOBAL:
+        return shortInstruction("OP_SET_GLOBAL");
+    case OP_GET_UPVALUE:
+        return ByteInstruction(os, "OP_GET_UPVALUE", mCode, offset);
+    case OP_SET_UPVALUE:
+        return ByteInstruction(os, "OP_SET_UPVALUE", mCode, offset);
+    case OP_GET_PROPERTY:
+        return constantInstruction("OP_GET_PROPERTY");
+    case OP_SET_PROPERTY:
+        return constantInstruction("OP_SET_PROPERTY");
+    case OP_GET_SUPER:
+        return constantInstruction("OP_GET_SUPER");
+    case OP_BUILD_LIST:
+        return shortInstruction("OP_BUILD_LIST");
+    case OP_BUILD_MAP:
+        return shortInstruction("OP_BUILD_MAP");
+    case OP_GET_INDEX:
+        return SimpleInstruction(os, "OP_GET_INDEX", offset);
+    case OP_SET_INDEX:
+        return SimpleInstruction(os, "OP_SET_INDEX", offset);
+    case OP_EQUAL:
+        return SimpleInstruction(os, "OP_EQUAL", offset);
+    case OP_GREATER:
+        return SimpleInstruction(os, "OP_GREATER", offset);
+    case OP_GREATER_EQUAL:
+        return SimpleInstruction(os, "OP_GREATER_EQUAL", offset);
+    case OP_LESS:
+        return SimpleInstruction(os, "OP_LESS", offset);
+    case OP_LESS_EQUAL:
+        return SimpleInstruction(os, "OP_LESS_EQUAL", offset);
+    case OP_ADD:
+        return SimpleInstruction(os, "OP_ADD", offset);
+    case OP_SUBTRACT:
+        return SimpleInstruction(os, "OP_SUBTRACT", offset);
+    case OP_MULTIPLY:
+        return SimpleInstruction(os, "OP_MULTIPLY", offset);
+    case OP_DIVIDE:
+        return SimpleInstruction(os, "OP_DIVIDE", offset);
+    case OP_NOT:
+        return SimpleInstruction(os, "OP_NOT", offset);
+    case OP_NEGATE:
+        return SimpleInstruction(os, "OP_NEGATE", offset);
+    case OP_PRINT:
+        return SimpleInstruction(os, "OP_PRINT", offset);
+    case OP_JUMP:
+        return JumpInstruction(os, "OP_JUMP", 1, mCode, offset);
+    case OP_JUMP_IF_FALSE:
+        return JumpInstruction(os, "OP_JUMP_IF_FALSE", 1, mCode, offset);
+    case OP_LOOP:
+        return JumpInstruction(os, "OP_LOOP", -1, mCode, offset);
+    case OP_CALL:
+        return ByteInstruction(os, "OP_CALL", mCode, offset);
+    case OP_INVOKE:
+        return invokeInstruction("OP_INVOKE");
+    case OP_SUPER_INVOKE:
+        return invokeInstruction("OP_SUPER_INVOKE");
+    case OP_CLOSURE: {
+        auto constant = ReadShort(mCode, offset + 1);
+        offset += 3;
+        auto &function = static_cast<VmFunction &>(*mConstants.at(constant).AsObj());
+        os << std::left << std::setw(16) << "OP_CLOSURE"
+           << " " << constant << " " << function.Str() << std::endl;
+        for (int i = 0; i < function.UpvalueCount(); i++)
+        {
+            auto isLocal = mCode.at(offset++);
+            auto index = mCode.at(offset++);
+            os << std::setfill('0') << std::right << std::setw(4) << (offset - 2) << std::setfill(' ')
+               << "    |                     " << (isLocal ? "local " : "upvalue ") << static_cast<int>(index)
+               << std::endl;
+        }
+        return offset;
+    }
+    case OP_CLOSE_UPVALUE:
+        return SimpleInstruction(os, "OP_CLOSE_UPVALUE", offset);
+    case OP_RETURN:
+        return SimpleInstruction(os, "OP_RETURN", offset);
+    case OP_CLASS:
+        return constantInstruction("OP_CLASS");
+    case OP_INHERIT:
+        return SimpleInstruction(os, "OP_INHERIT", offset);
+    case OP_METHOD:
+        return constantInstruction("OP_METHOD");
+    default:
+        os << "Unknown opcode " << static_cast<int>(mCode.at(offset)) << std::endl;
+        return offset + 1;
+    }
+}
+
+// The compiler only emits jumps for structured control flow, so every forward jump is seen before its target and
+// one pass in code order knows the height at each instruction.
+int Chunk::MaxStackHeight(int base) const
+{
+    // the height at each jump target, -1 where no jump lands
+    vector<int> targets(mCode.size() + 1, -1);
+    int height = base;
+    int maxHeight = base;
+
+    for (size_t offset = 0; offset < mCode.size();)
+    {
+        // code after an unconditional jump is only reached through a jump
+        height = std::max(height, targets[offset]);
+
+        auto op = mCode[offset];
+        size_t length = 1;
+        switch (op)
+        {
+        case OP_NIL:
+        case OP_TRUE:
+        case OP_FALSE:
+            height++;
+            break;
+        case OP_CONSTANT:
+        case OP_GET_GLOBAL:
+        case OP_CLASS:
+            height++;
+            length = 3;
+            break;
+        case OP_GET_LOCAL:
+        case OP_GET_UPVALUE:
+            height++;
+            length = 2;
+            break;
+        case OP_SET_LOCAL:
+        case OP_SET_UPVALUE:
+            length = 2;
+            break;
+        case OP_SET_GLOBAL:
+        case OP_GET_PROPERTY:
+            length = 3;
+            break;
+        case OP_DEFINE_GLOBAL:
+        case OP_SET_PROPERTY:
+        case OP_GET_SUPER:
+        case OP_METHOD:
+            height--;
+            length = 3;
+            break;
+        case OP_BUILD_LIST:
+            height += 1 - ReadShort(mCode, offset + 1);
+            length = 3;
+            break;
+        case OP_BUILD_MAP:
+            height += 1 - 2 * ReadShort(mCode, offset + 1);
+            length = 3;
+            break;
+        case OP_SET_INDEX:
+            height -= 2;
+            break;
+        case OP_POP:
+        case OP_GET_INDEX:
+        case OP_EQUAL:
+        case OP_GREATER:
+        case OP_GREATER_EQUAL:
+        case OP_LESS:
+        case OP_LESS_EQUAL:
+        case OP_ADD:
+        case OP_SUBTRACT:
+        case OP_MULTIPLY:
+        case OP_DIVIDE:
+        case OP_PRINT:
+        case OP_CLOSE_UPVALUE:
+        case OP_INHERIT:
+        case OP_RETURN:
+            height--;
+            break;
+        case OP_JUMP:
+        case OP_JUMP_IF_FALSE: {
+            auto target = offset + 3 + ReadShort(mCode, offset + 1);
+            targets[target] = std::max(targets[target], height);
+            length = 3;
+            break;
+        }
+        case OP_LOOP:
+            length = 3;
+            break;
+        case OP_CALL:
+            // the callee and the arguments are replaced by the result
+            height -= mCode[offset + 1];
+            length = 2;
+            break;
+        case OP_INVOKE:
+            height -= mCode[offset + 3];
+            length = 4;
+            break;
+        case OP_SUPER_INVOKE:
+            // the superclass is popped as well
+            height -= mCode[offset + 3] + 1;
+            length = 4;
+            break;
+        case OP_CLOSURE: {
+            auto &function = static_cast<VmFunction &>(*mConstants[ReadShort(mCode, offset + 1)].AsObj());
+            height++;
+            length = 3 + 2 * function.UpvalueCount();
+            break;
+        }
+        default:
+            break;
+        }
+
+        maxHeight = std::max(maxHeight, height);
+        offset += length;
+    }
+    return maxHeight;
+}
+
+} // namespace lox
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "Value.h"
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace lox
+{
+
+using std::vector;
+
+// Operand widths: constants, globals and jumps take two bytes (big endian),
+// locals, upvalues and argument counts take one.
+enum OpCode : uint8_t
+{
+    OP_CONSTANT,
+    OP_NIL,
+    OP_TRUE,
+    OP_FALSE,
+    OP_POP,
+    OP_GET_LOCAL,
+    OP_SET_LOCAL,
+    OP_GET_GLOBAL,
+    OP_DEFINE_GLOBAL,
+    OP_SET_GLOBAL,
+    OP_GET_UPVALUE,
+    OP_SET_UPVALUE,
+    OP_GET_PROPERTY,
+    OP_SET_PROPERTY,
+    OP_GET_SUPER,
+    OP_BUILD_LIST,
+    OP_BUILD_MAP,
+    OP_GET_INDEX,
+    OP_SET_INDEX,
+    OP_EQUAL,
+    OP_GREATER,
+    OP_GREATER_EQUAL,
+    OP_LESS,
+    OP_LESS_EQUAL,
+    OP_ADD,
+    OP_SUBTRACT,
+    OP_MULTIPLY,
+    OP_DIVIDE,
+    OP_NOT,
+    OP_NEGATE,
+    OP_PRINT,
+    OP_JUMP,
+    OP_JUMP_IF_FALSE,
+    OP_LOOP,
+    OP_CALL,
+    OP_INVOKE,
+    OP_SUPER_INVOKE,
+    OP_CLOSURE,
+    OP_CLOSE_UPVALUE,
+    OP_RETURN,
+    OP_CLASS,
+    OP_INHERIT,
+    OP_METHOD,
+};
+
+// A unit of bytecode: the instruction stream, its constant pool and a run-length encoded line table.
+class Chunk
+{
+  public:
+    void Write(uint8_t byte, int line);
+    size_t AddConstant(const Value &value);
+    int GetLine(size_t offset) const;
+
+    // the highest the stack gets while the code runs, counted from the first slot of its frame, which starts out
+    // holding base values
+    int MaxStackHeight(int base) const;
+
+    // lists the instructions, then the chunks of the functions among the constants
+    void Disassemble(std::ostream &os, const string &name) const;
+    size_t DisassembleInstruction(std::ostream &os, size_t offset) const;
+
+    vector<uint8_t> &Code()
+    {
+        return mCode;
+    }
+    const vector<uint8_t> &Code() const
+    {
+        return mCode;
+    }
+    const vector<Value> &Constants() const
+    {
+        return mConstants;
+    }
+
+  private:
+    // first instruction offset of each run of instructions sharing a line
+    struct LineStart
+    {
+        size_t mOffset;
+        int mLine;
+    };
+
+    vector<uint8_t> mCode;
+    vector<Value> mConstants;
+    vector<LineStart> mLines;
+};
+
+} // namespace lox
@@ -0,0 +1,661 @@
+#include "Compiler.h"
+#include "Lox.h"
+
+#include <limits>
+
+namespace lox
+{
+
+static constexpr int UINT8_COUNT = std::numeric_limits<uint8_t>::max() + 1;
+
+Value Compiler::Compile(const vector<Stmt *> &stmts)
+{
+    FunctionState state{nullptr, Value(mHeap.New<VmFunction>("")), FUNCTION_NONE, {}, {}, 0, {}};
+    state.mLocals.push_back(Local{"", 0, false});
+    mCurrent = &state;
+    mHadError = false;
+
+    for (auto &stmt : stmts)
+        Compile(*stmt);
+    EmitReturn();
+    static_cast<VmFunction *>(state.mFunction.AsObj())->SetMaxStackHeight(CurrentChunk().MaxStackHeight(1));
+
+    mCurrent = nullptr;
+    return mHadError ? Value() : state.mFunction;
+}
+
+void Compiler::Visit(const Expression &stmt)
+{
+    Compile(*stmt.mExpression);
+    Emit(OP_POP);
+}
+
+void Compiler::Visit(const Print &stmt)
+{
+    Compile(*stmt.mExpression);
+    Emit(OP_PRINT);
+}
+
+void Compiler::Visit(const Var &stmt)
+{
+    mLine = stmt.mName->Line();
+    DeclareLocal(*stmt.mName);
+
+    if (stmt.mInitializer)
+        Compile(*stmt.mInitializer);
+    else
+        Emit(OP_NIL);
+
+    mLine = stmt.mName->Line();
+    DefineVariable(*stmt.mName);
+}
+
+void Compiler::Visit(const Block &stmt)
+{
+    BeginScope();
+    for (auto &s : stmt.mStatements)
+        Compile(*s);
+    EndScope();
+}
+
+void Compiler::Visit(const If &stmt)
+{
+    Compile(*stmt.mCondition);
+
+    auto thenJump = EmitJump(OP_JUMP_IF_FALSE);
+    Emit(OP_POP);
+    Compile(*stmt.mThenBranch);
+
+    auto elseJump = EmitJump(OP_JUMP);
+    PatchJump(thenJump);
+    Emit(OP_POP);
+    if (stmt.mElseBranch)
+        Compile(*stmt.mElseBranch);
+    PatchJump(elseJump);
+}
+
+void Compiler::Visit(const While &stmt)
+{
+    auto loopStart = CurrentChunk().Code().size();
+    Compile(*stmt.mCondition);
+
+    auto exitJump = EmitJump(OP_JUMP_IF_FALSE);
+    Emit(OP_POP);
+    Compile(*stmt.mBody);
+    EmitLoop(loopStart);
+
+    PatchJump(exitJump);
+    Emit(OP_POP);
+}
+
+void Compiler::Visit(const Function &stmt)
+{
+    mLine = stmt.mName->Line();
+    DeclareLocal(*stmt.mName);
+    // a function may refer to itself recursively
+    MarkInitialized();
+
+    CompileFunction(stmt, FUNCTION_FUNCTION);
+
+    mLine = stmt.mName->Line();
+    DefineVariable(*stmt.mName);
+}
+
+void Compiler::Visit(const Return &stmt)
+{
+    mLine = stmt.mKeyword->Line();
+    if (!stmt.mValue)
+    {
+        EmitReturn();
+        return;
+    }
+
+    Compile(*stmt.mValue);
+    mLine = stmt.mKeyword->Line();
+    Emit(OP_RETURN);
+}
+
+void Compiler::Visit(const Class &stmt)
+{
+    mLine = stmt.mName->Line();
+    auto nameConstant = IdentifierConstant(stmt.mName->Lexeme());
+    DeclareLocal(*stmt.mName);
+
+    EmitShort(OP_CLASS, nameConstant);
+    DefineVariable(*stmt.mName);
+
+    ClassState classState{mCurrentClass, false};
+    mCurrentClass = &classState;
+
+    if (stmt.mSuperclass)
+    {
+        Compile(*stmt.mSuperclass);
+
+        BeginScope();
+        AddLocal("super");
+        MarkInitialized();
+
+        NamedVariable(stmt.mName->Lexeme(), false);
+        mLine = stmt.mSuperclass->mName->Line();
+        Emit(OP_INHERIT);
+        classState.mHasSuperclass = true;
+    }
+
+    NamedVariable(stmt.mName->Lexeme(), false);
+    for (auto &method : stmt.mMethods)
+    {
+        auto isInitializer = method->mName->Lexeme() == "init";
+        CompileFunction(*method, isInitializer ? FUNCTION_INITIALIZER : FUNCTION_METHOD);
+        mLine = method->mName->Line();
+        EmitShort(OP_METHOD, IdentifierConstant(method->mName->Lexeme()));
+    }
+    Emit(OP_POP);
+
+    if (classState.mHasSuperclass)
+        EndScope();
+
+    mCurrentClass = classState.mEnclosing;
+}
+
+void Compiler::Visit(const Assign &expr)
+{
+    Compile(*expr.mValue);
+    mLine = expr.mName->Line();
+    NamedVariable(expr.mName->Lexeme(), true);
+}
+
+void Compiler::Visit(const Binary &expr)
+{
+    Compile(*expr.mLeft);
+    Compile(*expr.mRight);
+
+    mLine = expr.mOp->Line();
+    switch (expr.mOp->Type())
+    {
+    case TOKEN_BANG_EQUAL:
+        Emit(OP_EQUAL, OP_NOT);
+        break;
+    case TOKEN_EQUAL_EQUAL:
+        Emit(OP_EQUAL);
+        break;
+    case TOKEN_GREATER:
+        Emit(OP_GREATER);
+        break;
+    case TOKEN_GREATER_EQUAL:
+        Emit(OP_GREATER_EQUAL);
+        break;
+    case TOKEN_LESS:
+        Emit(OP_LESS);
+        break;
+    case TOKEN_LESS_EQUAL:
+        Emit(OP_LESS_EQUAL);
+        break;
+    case TOKEN_MINUS:
+        Emit(OP_SUBTRACT);
+        break;
+    case TOKEN_PLUS:
+        Emit(OP_ADD);
+        break;
+    case TOKEN_SLASH:
+        Emit(OP_DIVIDE);
+        break;
+    case TOKEN_STAR:
+        Emit(OP_MULTIPLY);
+        break;
+    default:
+        throw std::runtime_error("[ERROR on Compiler::Visit(Binary)] Illegal op type: " +
+                                 to_string(expr.mOp->Type()));
+    }
+}
+
+void Compiler::Visit(const Call &expr)
+{
+    auto argCount = static_cast<uint8_t>(expr.mArguments.size());
+
+    // method calls skip creating a bound method
+    if (typeid(*expr.mCallee) == typeid(Get))
+    {
+        auto get = static_cast<const Get *>(expr.mCallee);
+        Compile(*get->mObject);
+        for (auto &argument : expr.mArguments)
+            Compile(*argument);
+
+        mLine = expr.mParen->Line();
+        EmitShort(OP_INVOKE, IdentifierConstant(get->mName->Lexeme()));
+        Emit(argCount);
+        return;
+    }
+
+    if (typeid(*expr.mCallee) == typeid(Super))
+    {
+        auto super = static_cast<const Super *>(expr.mCallee);
+        mLine = super->mKeyword->Line();
+        NamedVariable("this", false);
+        for (auto &argument : expr.mArguments)
+            Compile(*argument);
+
+        mLine = super->mKeyword->Line();
+        NamedVariable("super", false);
+        mLine = expr.mParen->Line();
+        EmitShort(OP_SUPER_INVOKE, IdentifierConstant(super->mMethod->Lexeme()));
+        Emit(argCount);
+        return;
+    }
+
+    Compile(*expr.mCallee);
+    for (auto &argument : expr.mArguments)
+        Compile(*argument);
+
+    mLine = expr.mParen->Line();
+    Emit(OP_CALL, argCount);
+}
+
+void Compiler::Visit(const Get &expr)
+{
+    Compile(*expr.mObject);
+    mLine = expr.mName->Line();
+    EmitShort(OP_GET_PROPERTY, IdentifierConstant(expr.mName->Lexeme()));
+}
+
+void Compiler::Visit(const Grouping &expr)
+{
+    Compile(*expr.mExpression);
+}
+
+void Compiler::Visit(const Index &expr)
+{
+    Compile(*expr.mObject);
+    Compile(*expr.mIndex);
+    mLine = expr.mBracket->Line();
+    Emit(OP_GET_INDEX);
+}
+
+void Compiler::Visit(const ListLiteral &expr)
+{
+    for (auto element : expr.mElements)
+        Compile(*element);
+
+    mLine = expr.mBracket->Line();
+    if (expr.mElements.size() > std::numeric_limits<uint16_t>::max())
+        Error("Too many elements in list literal.");
+    EmitShort(OP_BUILD_LIST, static_cast<uint16_t>(expr.mElements.size()));
+}
+
+void Compiler::Visit(const Literal &expr)
+{
+    auto &object = *expr.mValue;
+    switch (object.Type())
+    {
+    case OBJ_NIL:
+        Emit(OP_NIL);
+        break;
+    case OBJ_BOOL:
+        Emit(object.Bool() ? OP_TRUE : OP_FALSE);
+        break;
+    case OBJ_NUMBER:
+        EmitShort(OP_CONSTANT, MakeConstant(Value(object.Number())));
+        break;
+    case OBJ_TEXT:
+        EmitShort(OP_CONSTANT, MakeConstant(Value(mHeap.Intern(object.Text()))));
+        break;
+    default:
+        throw std::runtime_error("[ERROR on Compiler::Visit(Literal)] Illegal object type: " +
+                                 to_string(object.Type()));
+    }
+}
+
+void Compiler::Visit(const Logical &expr)
+{
+    Compile(*expr.mLeft);
+
+    mLine = expr.mOp->Line();
+    if (expr.mOp->Type() == TOKEN_OR)
+    {
+        auto elseJump = EmitJump(OP_JUMP_IF_FALSE);
+        auto endJump = EmitJump(OP_JUMP);
+
+        PatchJump(elseJump);
+        Emit(OP_POP);
+
+        Compile(*expr.mRight);
+        PatchJump(endJump);
+    }
+    else
+    {
+        auto endJump = EmitJump(OP_JUMP_IF_FALSE);
+
+        Emit(OP_POP);
+        Compile(*expr.mRight);
+
+        PatchJump(endJump);
+    }
+}
+
+void Compiler::Visit(const MapLiteral &expr)
+{
+    for (size_t i = 0; i < expr.mKeys.size(); i++)
+    {
+        Compile(*expr.mKeys[i]);
+        Compile(*expr.mValues[i]);
+    }
+
+    mLine = expr.mBrace->Line();
+    if (expr.mKeys.size() > std::numeric_limits<uint16_t>::max())
+        Error("Too many entries in map literal.");
+    EmitShort(OP_BUILD_MAP, static_cast<uint16_t>(expr.mKeys.size()));
+}
+
+void Compiler::Visit(const Set &expr)
+{
+    Compile(*expr.mObject);
+    Compile(*expr.mValue);
+    mLine = expr.mName->Line();
+    EmitShort(OP_SET_PROPERTY, IdentifierConstant(expr.mName->Lexeme()));
+}
+
+void Compiler::Visit(const SetIndex &expr)
+{
+    Compile(*expr.mObject);
+    Compile(*expr.mIndex);
+    Compile(*expr.mValue);
+    mLine = expr.mBracket->Line();
+    Emit(OP_SET_INDEX);
+}
+
+void Compiler::Visit(const Super &expr)
+{
+    mLine = expr.mKeyword->Line();
+    NamedVariable("this", false);
+    NamedVariable("super", false);
+    EmitShort(OP_GET_SUPER, IdentifierConstant(expr.mMethod->Lexeme()));
+}
+
+void Compiler::Visit(const This &expr)
+{
+    mLine = expr.mKeyword->Line();
+    NamedVariable("this", false);
+}
+
+void Compiler::Visit(const Unary &expr)
+{
+    Compile(*expr.mRight);
+
+    mLine = expr.mOp->Line();
+    switch (expr.mOp->Type())
+    {
+    case TOKEN_BANG:
+        Emit(OP_NOT);
+        break;
+    case TOKEN_MINUS:
+        Emit(OP_NEGATE);
+        break;
+    default:
+        throw std::runtime_error("[ERROR on Compiler::Visit(Unary)] Illegal op type: " + to_string(expr.mOp->Type()));
+    }
+}
+
+void Compiler::Visit(const Variable &expr)
+{
+    mLine = expr.mName->Line();
+    NamedVariable(expr.mName->Lexeme(), false);
+}
+
+void Compiler::Compile(const Stmt &stmt)
+{
+    stmt.Accept(*this);
+}
+
+void Compiler::Compile(const Expr &expr)
+{
+    expr.Accept(*this);
+}
+
+void Compiler::CompileFunction(const Function &func, FunctionType type)
+{
+    auto function = mHeap.New<VmFunction>(func.mName->Lexeme());
+    function->SetArity(static_cast<int>(func.mParams.size()));
+
+    FunctionState state{mCurrent, Value(function), type, {}, {}, 0, {}};
+    // slot zero holds the receiver for methods and the callee itself otherwise
+    state.mLocals.push_back(Local{type == FUNCTION_FUNCTION ? "" : "this", 0, false});
+    mCurrent = &state;
+
+    BeginScope();
+    for (auto &param : func.mParams)
+    {
+        mLine = param->Line();
+        DeclareLocal(*param);
+        MarkInitialized();
+    }
+    for (auto &stmt : func.mBody)
+        Compile(*stmt);
+    EmitReturn();
+
+    function->SetUpvalueCount(static_cast<int>(state.mUpvalues.size()));
+    function->SetMaxStackHeight(CurrentChunk().MaxStackHeight(function->Arity() + 1));
+    mCurrent = state.mEnclosing;
+
+    mLine = func.mName->Line();
+    EmitShort(OP_CLOSURE, MakeConstant(state.mFunction));
+    for (auto &upvalue : state.mUpvalues)
+        Emit(upvalue.mIsLocal ? 1 : 0, upvalue.mIndex);
+}
+
+Chunk &Compiler::CurrentChunk()
+{
+    return static_cast<VmFunction *>(mCurrent->mFunction.AsObj())->GetChunk();
+}
+
+void Compiler::Emit(uint8_t byte)
+{
+    CurrentChunk().Write(byte, mLine);
+}
+
+void Compiler::Emit(uint8_t byte1, uint8_t byte2)
+{
+    Emit(byte1);
+    Emit(byte2);
+}
+
+void Compiler::EmitShort(uint8_t op, uint16_t operand)
+{
+    Emit(op);
+    Emit(static_cast<uint8_t>((operand >> 8) & 0xff), static_cast<uint8_t>(operand & 0xff));
+}
+
+size_t Compiler::EmitJump(uint8_t op)
+{
+    EmitShort(op, 0xffff);
+    return CurrentChunk().Code().size() - 2;
+}
+
+void Compiler::PatchJump(size_t offset)
+{
+    auto &code = CurrentChunk().Code();
+    // -2 to adjust for the bytecode for the jump offset itself
+    auto jump = code.size() - offset - 2;
+    if (jump > std::numeric_limits<uint16_t>::max())
+        Error("Too much code to jump over.");
+
+    code[offset] = (jump >> 8) & 0xff;
+    code[offset + 1] = jump & 0xff;
+}
+
+void Compiler::EmitLoop(size_t loopStart)
+{
+    auto offset = CurrentChunk().Code().size() - loopStart + 3;
+    if (offset > std::numeric_limits<uint16_t>::max())
+        Error("Loop body too large.");
+
+    EmitShort(OP_LOOP, static_cast<uint16_t>(offset));
+}
+
+void Compiler::EmitReturn()
+{
+    if (mCurrent->mType == FUNCTION_INITIALIZER)
+        Emit(OP_GET_LOCAL, 0);
+    else
+        Emit(OP_NIL);
+    Emit(OP_RETURN);
+}
+
+uint16_t Compiler::MakeConstant(const Value &value)
+{
+    auto constant = CurrentChunk().AddConstant(value);
+    if (constant > std::numeric_limits<uint16_t>::max())
+    {
+        Error("Too many constants in one chunk.");
+        return 0;
+    }
+    return static_cast<uint16_t>(constant);
+}
+
+uint16_t Compiler::IdentifierConstant(const string &name)
+{
+    auto &identifiers = mCurrent->mIdentifiers;
+    auto found = identifiers.find(name);
+    if (found != identifiers.end())
+        return found->second;
+
+    auto constant = MakeConstant(Value(mHeap.Intern(name)));
+    identifiers.emplace(name, constant);
+    return constant;
+}
+
+uint16_t Compiler::GlobalSlot(const string &name)
+{
+    auto slot = mGlobals.Slot(name);
+    if (slot > std::numeric_limits<uint16_t>::max())
+    {
+        Error("Too many global variables.");
+        return 0;
+    }
+    return static_cast<uint16_t>(slot);
+}
+
+void Compiler::BeginScope()
+{
+    mCurrent->mScopeDepth++;
+}
+
+void Compiler::EndScope()
+{
+    auto &locals = mCurrent->mLocals;
+    mCurrent->mScopeDepth--;
+
+    while (!locals.empty() && locals.back().mDepth > mCurrent->mScopeDepth)
+    {
+        Emit(locals.back().mIsCaptured ? OP_CLOSE_UPVALUE : OP_POP);
+        locals.pop_back();
+    }
+}
+
+void Compiler::AddLocal(const string &name)
+{
+    if (mCurrent->mLocals.size() == UINT8_COUNT)
+    {
+        Error("Too many local variables in function.");
+        return;
+    }
+    mCurrent->mLocals.push_back(Local{name, -1, false});
+}
+
+void Compiler::DeclareLocal(const Token &name)
+{
+    // globals are late bound, duplicated locals were already reported by the Resolver
+    if (mCurrent->mScopeDepth == 0)
+        return;
+    AddLocal(name.Lexeme());
+}
+
+void Compiler::MarkInitialized()
+{
+    if (mCurrent->mScopeDepth == 0)
+        return;
+    mCurrent->mLocals.back().mDepth = mCurrent->mScopeDepth;
+}
+
+void Compiler::DefineVariable(const Token &name)
+{
+    if (mCurrent->mScopeDepth > 0)
+    {
+        MarkInitialized();
+        return;
+    }
+    EmitShort(OP_DEFINE_GLOBAL, GlobalSlot(name.Lexeme()));
+}
+
+int Compiler::ResolveLocal(FunctionState &state, const string &name)
+{
+    for (int i = static_cast<int>(state.mLocals.size()) - 1; i >= 0; i--)
+    {
+        if (state.mLocals[i].mName == name)
+            return i;
+    }
+    return -1;
+}
+
+int Compiler::ResolveUpvalue(FunctionState &state, const string &name)
+{
+    if (!state.mEnclosing)
+        return -1;
+
+    auto local = ResolveLocal(*state.mEnclosing, name);
+    if (local != -1)
+    {
+        state.mEnclosing->mLocals[local].mIsCaptured = true;
+        return AddUpvalue(state, static_cast<uint8_t>(local), true);
+    }
+
+    auto upvalue = ResolveUpvalue(*state.mEnclosing, name);
+    if (upvalue != -1)
+        return AddUpvalue(state, static_cast<uint8_t>(upvalue), false);
+
+    return -1;
+}
+
+int Compiler::AddUpvalue(FunctionState &state, uint8_t index, bool isLocal)
+{
+    auto &upvalues = state.mUpvalues;
+    for (size_t i = 0; i < upvalues.size(); i++)
+    {
+        if (upvalues[i].mIndex == index && upvalues[i].mIsLocal == isLocal)
+            return static_cast<int>(i);
+    }
+
+    if (upvalues.size() == UINT8_COUNT)
+    {
+        Error("Too many closure variables in function.");
+        return 0;
+    }
+
+    upvalues.push_back(Upvalue{index, isLocal});
+    return static_cast<int>(upvalues.size() - 1);
+}
+
+void Compiler::NamedVariable(const string &name, bool assign)
+{
+    auto slot = ResolveLocal(*mCurrent, name);
+    if (slot != -1)
+    {
+        Emit(assign ? OP_SET_LOCAL : OP_GET_LOCAL, static_cast<uint8_t>(slot));
+        return;
+    }
+
+    slot = ResolveUpvalue(*mCurrent, name);
+    if (slot != -1)
+    {
+        Emit(assign ? OP_SET_UPVALUE : OP_GET_UPVALUE, static_cast<uint8_t>(slot));
+        return;
+    }
+
+    EmitShort(assign ? OP_SET_GLOBAL : OP_GET_GLOBAL, GlobalSlot(name));
+}
+
+void Compiler::Error(const string &message)
+{
+    Lox::Error(mLine, message);
+    mHadError = true;
+}
+
+} // namespace lox
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "Chunk.h"
+#include "Expr.h"
+#include "GlobalTable.h"
+#include "Heap.h"
+#include "Resolver.h"
+#include "Stmt.h"
+#include "VmObject.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lox
+{
+
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+// Compiles a resolved syntax tree into bytecode for the VM.
+// Locals live in stack slots and captured variables are reached through upvalues, like clox.
+class Compiler : public Expr::Visitor<void>, public Stmt::Visitor<void>
+{
+  public:
+    Compiler(GlobalTable &globals, Heap &heap) : mGlobals(globals), mHeap(heap)
+    {
+    }
+
+    // returns the top level script function, or nil if a compile error was reported
+    Value Compile(const vector<Stmt *> &stmts);
+
+    void Visit(const Expression &stmt);
+    void Visit(const Print &stmt);
+    void Visit(const Var &stmt);
+    void Visit(const Block &stmt);
+    void Visit(const If &stmt);
+    void Visit(const While &stmt);
+    void Visit(const Function &stmt);
+    void Visit(const Return &stmt);
+    void Visit(const Class &stmt);
+
+    void Visit(const Assign &expr);
+    void Visit(const Binary &expr);
+    void Visit(const Call &expr);
+    void Visit(const Get &expr);
+    void Visit(const Grouping &expr);
+    void Visit(const Index &expr);
+    void Visit(const ListLiteral &expr);
+    void Visit(const Literal &expr);
+    void Visit(const Logical &expr);
+    void Visit(const MapLiteral &expr);
+    void Visit(const Set &expr);
+    void Visit(const SetIndex &expr);
+    void Visit(const Super &expr);
+    void Visit(const This &expr);
+    void Visit(const Unary &expr);
+    void Visit(const Variable &expr);
+
+  private:
+    struct Local
+    {
+        string mName;
+        int mDepth; // -1 while the initializer is being compiled
+        bool mIsCaptured;
+    };
+
+    struct Upvalue
+    {
+        uint8_t mIndex;
+        bool mIsLocal;
+    };
+
+    // per function compilation state, chained to the enclosing function
+    struct FunctionState
+    {
+        FunctionState *mEnclosing;
+        Value mFunction;
+        FunctionType mType;
+        vector<Local> mLocals;
+        vector<Upvalue> mUpvalues;
+        int mScopeDepth;
+        unordered_map<string, uint16_t> mIdentifiers;
+    };
+
+    struct ClassState
+    {
+        ClassState *mEnclosing;
+        bool mHasSuperclass;
+    };
+
+    void Compile(const Stmt &stmt);
+    void Compile(const Expr &expr);
+    void CompileFunction(const Function &func, FunctionType type);
+
+    Chunk &CurrentChunk();
+    void Emit(uint8_t byte);
+    void Emit(uint8_t byte1, uint8_t byte2);
+    void EmitShort(uint8_t op, uint16_t operand);
+    size_t EmitJump(uint8_t op);
+    void PatchJump(size_t offset);
+    void EmitLoop(size_t loopStart);
+    void EmitReturn();
+    uint16_t MakeConstant(const Value &value);
+    uint16_t IdentifierConstant(const string &name);
+    uint16_t GlobalSlot(const string &name);
+
+    void BeginScope();
+    void EndScope();
+    void AddLocal(const string &name);
+    void DeclareLocal(const Token &name);
+    void MarkInitialized();
+    void DefineVariable(const Token &name);
+    int ResolveLocal(FunctionState &state, const string &name);
+    int ResolveUpvalue(FunctionState &state, const string &name);
+    int AddUpvalue(FunctionState &state, uint8_t index, bool isLocal);
+    void NamedVariable(const string &name, bool assign);
+
+    void Error(const string &message);
+
+    GlobalTable &mGlobals;
+    // nothing is collected while compiling, the VM only collects when it runs
+    Heap &mHeap;
+    FunctionState *mCurrent = nullptr;
+    ClassState *mCurrentClass = nullptr;
+    int mLine = 1;
+    bool mHadError = false;
+};
+
+} // namespace lox
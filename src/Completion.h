@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Value.h"
+
+namespace lox
+{
+
+enum CompletionType
+{
+    COMPLETION_NORMAL,
+    COMPLETION_RETURN,
+};
+
+// How the execution of a statement ended. A return statement completes with COMPLETION_RETURN and its value, which
+// every enclosing statement hands back up to the function call that runs the body.
+struct Completion
+{
+    CompletionType mType = COMPLETION_NORMAL;
+    Value mValue;
+};
+
+} // namespace lox
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Object.h"
+#include "Shape.h"
+#include "Slot.h"
 #include "Token.h"
 #include "Value.h"
 #include <memory>
@@ -8,7 +10,7 @@
 
 #define V_EXPR_ACCEPT_METHODS                                                                                          \
     virtual string Accept(Visitor<string> &visitor) const = 0;                                                         \
-    virtual shared_ptr<Value> Accept(Visitor<shared_ptr<Value>> &visitor) const = 0;                                   \
+    virtual Value Accept(Visitor<Value> &visitor) const = 0;                                                           \
     virtual void Accept(Visitor<void> &visitor) const = 0;
 
 #define EXPR_ACCEPT_METHODS                                                                                            \
@@ -16,7 +18,7 @@
     {                                                                                                                  \
         return visitor.Visit(*this);                                                                                   \
     }                                                                                                                  \
-    shared_ptr<Value> Accept(Visitor<shared_ptr<Value>> &visitor) const override                                       \
+    Value Accept(Visitor<Value> &visitor) const override                                                               \
     {                                                                                                                  \
         return visitor.Visit(*this);                                                                                   \
     }                                                                                                                  \
@@ -28,7 +30,6 @@
 namespace lox
 {
 
-using std::shared_ptr;
 using std::vector;
 
 class Assign;
@@ -36,9 +37,13 @@ class Binary;
 class Call;
 class Get;
 class Grouping;
+class Index;
+class ListLiteral;
 class Literal;
 class Logical;
+class MapLiteral;
 class Set;
+class SetIndex;
 class Super;
 class This;
 class Unary;
@@ -55,9 +60,13 @@ class Expr
         virtual R Visit(const Call &expr) = 0;
         virtual R Visit(const Get &expr) = 0;
         virtual R Visit(const Grouping &expr) = 0;
+        virtual R Visit(const Index &expr) = 0;
+        virtual R Visit(const ListLiteral &expr) = 0;
         virtual R Visit(const Literal &expr) = 0;
         virtual R Visit(const Logical &expr) = 0;
+        virtual R Visit(const MapLiteral &expr) = 0;
         virtual R Visit(const Set &expr) = 0;
+        virtual R Visit(const SetIndex &expr) = 0;
         virtual R Visit(const Super &expr) = 0;
         virtual R Visit(const This &expr) = 0;
         virtual R Visit(const Unary &expr) = 0;
@@ -70,12 +79,14 @@ class Expr
 class Assign : public Expr
 {
   public:
-    Assign(const shared_ptr<Token> &name, const shared_ptr<Expr> &value) : mName(name), mValue(value)
+    Assign(Token *name, Expr *value) : mName(name), mValue(value)
     {
     }
 
-    shared_ptr<Token> mName;
-    shared_ptr<Expr> mValue;
+    Token *mName;
+    Expr *mValue;
+    mutable Slot mSlot;
+    mutable GlobalSite mGlobal;
 
     EXPR_ACCEPT_METHODS
 };
@@ -83,14 +94,13 @@ class Assign : public Expr
 class Binary : public Expr
 {
   public:
-    Binary(const shared_ptr<Expr> &left, const shared_ptr<Token> &op, const shared_ptr<Expr> &right)
-        : mLeft(left), mOp(op), mRight(right)
+    Binary(Expr *left, Token *op, Expr *right) : mLeft(left), mOp(op), mRight(right)
     {
     }
 
-    shared_ptr<Expr> mLeft;
-    shared_ptr<Token> mOp;
-    shared_ptr<Expr> mRight;
+    Expr *mLeft;
+    Token *mOp;
+    Expr *mRight;
 
     EXPR_ACCEPT_METHODS
 };
@@ -98,14 +108,14 @@ class Binary : public Expr
 class Call : public Expr
 {
   public:
-    Call(const shared_ptr<Expr> &callee, const shared_ptr<Token> &paren, const vector<shared_ptr<Expr>> &arguments)
+    Call(Expr *callee, Token *paren, const vector<Expr *> &arguments)
         : mCallee(callee), mParen(paren), mArguments(arguments)
     {
     }
 
-    shared_ptr<Expr> mCallee;
-    shared_ptr<Token> mParen;
-    vector<shared_ptr<Expr>> mArguments;
+    Expr *mCallee;
+    Token *mParen;
+    vector<Expr *> mArguments;
 
     EXPR_ACCEPT_METHODS
 };
@@ -113,12 +123,13 @@ class Call : public Expr
 class Get : public Expr
 {
   public:
-    Get(const shared_ptr<Expr> &object, const shared_ptr<Token> &name) : mObject(object), mName(name)
+    Get(Expr *object, Token *name) : mObject(object), mName(name)
     {
     }
 
-    shared_ptr<Expr> mObject;
-    shared_ptr<Token> mName;
+    Expr *mObject;
+    Token *mName;
+    mutable PropertySite mSite;
 
     EXPR_ACCEPT_METHODS
 };
@@ -126,11 +137,38 @@ class Get : public Expr
 class Grouping : public Expr
 {
   public:
-    Grouping(const shared_ptr<Expr> &expression) : mExpression(expression)
+    Grouping(Expr *expression) : mExpression(expression)
     {
     }
 
-    shared_ptr<Expr> mExpression;
+    Expr *mExpression;
+
+    EXPR_ACCEPT_METHODS
+};
+
+class Index : public Expr
+{
+  public:
+    Index(Expr *object, Token *bracket, Expr *index) : mObject(object), mBracket(bracket), mIndex(index)
+    {
+    }
+
+    Expr *mObject;
+    Token *mBracket;
+    Expr *mIndex;
+
+    EXPR_ACCEPT_METHODS
+};
+
+class ListLiteral : public Expr
+{
+  public:
+    ListLiteral(Token *bracket, const vector<Expr *> &elements) : mBracket(bracket), mElements(elements)
+    {
+    }
+
+    Token *mBracket;
+    vector<Expr *> mElements;
 
     EXPR_ACCEPT_METHODS
 };
@@ -138,11 +176,12 @@ class Grouping : public Expr
 class Literal : public Expr
 {
   public:
-    Literal(const shared_ptr<Object> &value) : mValue(value)
+    Literal(Object *value) : mValue(value)
     {
     }
 
-    shared_ptr<Object> mValue;
+    Object *mValue;
+    mutable StringSite mSite;
 
     EXPR_ACCEPT_METHODS
 };
@@ -150,14 +189,28 @@ class Literal : public Expr
 class Logical : public Expr
 {
   public:
-    Logical(const shared_ptr<Expr> &left, const shared_ptr<Token> &op, const shared_ptr<Expr> &right)
-        : mLeft(left), mOp(op), mRight(right)
+    Logical(Expr *left, Token *op, Expr *right) : mLeft(left), mOp(op), mRight(right)
     {
     }
 
-    shared_ptr<Expr> mLeft;
-    shared_ptr<Token> mOp;
-    shared_ptr<Expr> mRight;
+    Expr *mLeft;
+    Token *mOp;
+    Expr *mRight;
+
+    EXPR_ACCEPT_METHODS
+};
+
+class MapLiteral : public Expr
+{
+  public:
+    MapLiteral(Token *brace, const vector<Expr *> &keys, const vector<Expr *> &values)
+        : mBrace(brace), mKeys(keys), mValues(values)
+    {
+    }
+
+    Token *mBrace;
+    vector<Expr *> mKeys;
+    vector<Expr *> mValues;
 
     EXPR_ACCEPT_METHODS
 };
@@ -165,14 +218,30 @@ class Logical : public Expr
 class Set : public Expr
 {
   public:
-    Set(const shared_ptr<Expr> &object, const shared_ptr<Token> &name, const shared_ptr<Expr> &value)
-        : mObject(object), mName(name), mValue(value)
+    Set(Expr *object, Token *name, Expr *value) : mObject(object), mName(name), mValue(value)
+    {
+    }
+
+    Expr *mObject;
+    Token *mName;
+    Expr *mValue;
+    mutable PropertySite mSite;
+
+    EXPR_ACCEPT_METHODS
+};
+
+class SetIndex : public Expr
+{
+  public:
+    SetIndex(Expr *object, Token *bracket, Expr *index, Expr *value)
+        : mObject(object), mBracket(bracket), mIndex(index), mValue(value)
     {
     }
 
-    shared_ptr<Expr> mObject;
-    shared_ptr<Token> mName;
-    shared_ptr<Expr> mValue;
+    Expr *mObject;
+    Token *mBracket;
+    Expr *mIndex;
+    Expr *mValue;
 
     EXPR_ACCEPT_METHODS
 };
@@ -180,12 +249,15 @@ class Set : public Expr
 class Super : public Expr
 {
   public:
-    Super(const shared_ptr<Token> &keyword, const shared_ptr<Token> &method) : mKeyword(keyword), mMethod(method)
+    Super(Token *keyword, Token *method) : mKeyword(keyword), mMethod(method)
     {
     }
 
-    shared_ptr<Token> mKeyword;
-    shared_ptr<Token> mMethod;
+    Token *mKeyword;
+    Token *mMethod;
+    mutable Slot mSlot;
+    mutable Slot mReceiver;
+    mutable int mTarget = -1;
 
     EXPR_ACCEPT_METHODS
 };
@@ -193,11 +265,12 @@ class Super : public Expr
 class This : public Expr
 {
   public:
-    This(const shared_ptr<Token> &keyword) : mKeyword(keyword)
+    This(Token *keyword) : mKeyword(keyword)
     {
     }
 
-    shared_ptr<Token> mKeyword;
+    Token *mKeyword;
+    mutable Slot mSlot;
 
     EXPR_ACCEPT_METHODS
 };
@@ -205,12 +278,12 @@ class This : public Expr
 class Unary : public Expr
 {
   public:
-    Unary(const shared_ptr<Token> &op, const shared_ptr<Expr> &right) : mOp(op), mRight(right)
+    Unary(Token *op, Expr *right) : mOp(op), mRight(right)
     {
     }
 
-    shared_ptr<Token> mOp;
-    shared_ptr<Expr> mRight;
+    Token *mOp;
+    Expr *mRight;
 
     EXPR_ACCEPT_METHODS
 };
@@ -218,11 +291,13 @@ class Unary : public Expr
 class Variable : public Expr
 {
   public:
-    Variable(const shared_ptr<Token> &name) : mName(name)
+    Variable(Token *name) : mName(name)
     {
     }
 
-    shared_ptr<Token> mName;
+    Token *mName;
+    mutable Slot mSlot;
+    mutable GlobalSite mGlobal;
 
     EXPR_ACCEPT_METHODS
 };
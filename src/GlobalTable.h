@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Heap.h"
+#include "StringHash.h"
+#include "Value.h"
+#include <string>
+#include <vector>
+
+namespace lox
+{
+
+using std::string;
+using std::vector;
+
+// Global variables addressed by a slot index that is handed out the first time a name is seen.
+// Names are only hashed when code is compiled, or when the tree walker first runs a site; accesses at runtime index
+// straight into the table. A slot stays with its name for the life of the table, so redefining a name reuses it.
+class GlobalTable
+{
+  public:
+    int Slot(const HashedString &name)
+    {
+        auto found = mSlots.find(name);
+        if (found != mSlots.end())
+            return found->second;
+
+        auto slot = static_cast<int>(mEntries.size());
+        mSlots.emplace(string(name.mString), slot);
+        mEntries.push_back(Entry{Value(), false});
+        mNames.emplace_back(name.mString);
+        return slot;
+    }
+
+    // the slot of a name seen before, -1 otherwise
+    int Find(const HashedString &name) const
+    {
+        auto found = mSlots.find(name);
+        return found != mSlots.end() ? found->second : -1;
+    }
+
+    const string &Name(int slot) const
+    {
+        return mNames[slot];
+    }
+    bool IsDefined(int slot) const
+    {
+        return mEntries[slot].mDefined;
+    }
+    const Value &Get(int slot) const
+    {
+        return mEntries[slot].mValue;
+    }
+    void Define(int slot, const Value &value)
+    {
+        mEntries[slot].mValue = value;
+        mEntries[slot].mDefined = true;
+    }
+    void Set(int slot, const Value &value)
+    {
+        mEntries[slot].mValue = value;
+    }
+
+    size_t Size() const
+    {
+        return mEntries.size();
+    }
+
+    void Trace(Heap &heap) const
+    {
+        for (auto &entry : mEntries)
+            heap.Mark(entry.mValue);
+    }
+
+  private:
+    struct Entry
+    {
+        Value mValue;
+        bool mDefined;
+    };
+
+    StringMap<int> mSlots;
+    vector<Entry> mEntries;
+    vector<string> mNames;
+};
+
+} // namespace lox
@@ -0,0 +1,56 @@
+#include "Heap.h"
+
+#include <algorithm>
+
+namespace lox
+{
+
+Heap::~Heap()
+{
+    while (mObjects)
+    {
+        auto next = mObjects->mNext;
+        delete mObjects;
+        mObjects = next;
+    }
+}
+
+void Heap::Collect(const std::function<void(Heap &heap)> &markRoots)
+{
+    markRoots(*this);
+    while (!mGray.empty())
+    {
+        auto object = mGray.back();
+        mGray.pop_back();
+        object->Trace(*this);
+    }
+    Sweep();
+
+    mNextGc = std::max(static_cast<size_t>(mBytes * mConfig.mGrowthFactor), mConfig.mInitialThreshold);
+    mStats.mCollections++;
+}
+
+void Heap::Sweep()
+{
+    auto link = &mObjects;
+    while (*link)
+    {
+        auto object = *link;
+        if (object->mMarked)
+        {
+            object->mMarked = false;
+            link = &object->mNext;
+            continue;
+        }
+
+        *link = object->mNext;
+        if (object->Kind() == OBJ_KIND_STRING)
+            mStrings.erase(static_cast<LoxString *>(object));
+        mBytes -= object->mSize;
+        mStats.mObjectsFreed++;
+        mStats.mBytesFreed += object->mSize;
+        delete object;
+    }
+}
+
+} // namespace lox
@@ -0,0 +1,209 @@
+#pragma once
+
+#include "Value.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace lox
+{
+
+using std::vector;
+
+struct GcConfig
+{
+    // a collection is triggered once this many bytes are live ...
+    size_t mInitialThreshold = 1024 * 1024;
+    // ... after which the threshold becomes the surviving bytes times this factor
+    double mGrowthFactor = 2.0;
+    // collect at every opportunity, for testing
+    bool mStress = false;
+};
+
+struct GcStats
+{
+    size_t mCollections = 0;
+    size_t mObjectsAllocated = 0;
+    size_t mObjectsFreed = 0;
+    size_t mBytesAllocated = 0;
+    size_t mBytesFreed = 0;
+    size_t mPeakBytes = 0;
+};
+
+// Owns every runtime object and reclaims the unreachable ones with a tracing mark and sweep collector.
+// Collection only happens when the owning engine asks for it at a point where all live objects are reachable
+// from the roots it marks, so cycles (a closure stored in its own environment, ...) are reclaimed as well.
+class Heap
+{
+  public:
+    Heap() : Heap(GcConfig())
+    {
+    }
+    Heap(const GcConfig &config) : mConfig(config), mNextGc(config.mInitialThreshold)
+    {
+    }
+    Heap(const Heap &) = delete;
+    Heap &operator=(const Heap &) = delete;
+    ~Heap();
+
+    template <typename T, typename... Args> T *New(Args &&...args)
+    {
+        static_assert(!std::is_same_v<T, LoxString>, "strings are created through Intern");
+        auto object = new T(std::forward<Args>(args)...);
+        Register(object, sizeof(T) + StorageBytes(*object));
+        return object;
+    }
+
+    // Objects that own growable storage, lists and maps, report its size through StorageBytes and call Resize
+    // whenever it changes, so that it counts towards the next collection like the objects themselves do.
+    template <typename T> static size_t StorageBytes(const T &object)
+    {
+        if constexpr (requires { object.StorageBytes(); })
+            return object.StorageBytes();
+        return 0;
+    }
+    template <typename T> void Resize(T *object)
+    {
+        Resize(static_cast<Obj *>(object), sizeof(T) + object->StorageBytes());
+    }
+
+    // the string of this heap equal to str, created if there is none yet
+    LoxString *Intern(const string &str)
+    {
+        return Intern(HashedString(str));
+    }
+    LoxString *Intern(const char *str)
+    {
+        return Intern(HashedString(str));
+    }
+    LoxString *Intern(string &&str)
+    {
+        auto hash = HashString(str);
+        auto found = mStrings.find(HashedString{str, hash});
+        if (found != mStrings.end())
+            return *found;
+        return AddString(new LoxString(std::move(str), hash));
+    }
+    LoxString *Intern(const HashedString &str)
+    {
+        auto found = mStrings.find(str);
+        if (found != mStrings.end())
+            return *found;
+        return AddString(new LoxString(string(str.mString), str.mHash));
+    }
+
+    bool ShouldCollect() const
+    {
+        return mConfig.mStress || mBytes > mNextGc;
+    }
+    // markRoots is expected to Mark every root of the caller
+    void Collect(const std::function<void(Heap &heap)> &markRoots);
+
+    void Mark(Obj *object)
+    {
+        if (!object || object->mMarked)
+            return;
+        object->mMarked = true;
+        mGray.push_back(object);
+    }
+    void Mark(const Value &value)
+    {
+        if (value.IsObj())
+            Mark(value.AsObj());
+    }
+
+    size_t Bytes() const
+    {
+        return mBytes;
+    }
+    const GcStats &Stats() const
+    {
+        return mStats;
+    }
+
+  private:
+    struct StringSetHasher
+    {
+        using is_transparent = void;
+
+        size_t operator()(const LoxString *str) const
+        {
+            return str->Hash();
+        }
+        size_t operator()(const HashedString &str) const
+        {
+            return str.mHash;
+        }
+    };
+    struct StringSetEqual
+    {
+        using is_transparent = void;
+
+        bool operator()(const LoxString *a, const LoxString *b) const
+        {
+            return a == b;
+        }
+        bool operator()(const HashedString &a, const LoxString *b) const
+        {
+            return a.mString == b->AsString();
+        }
+        bool operator()(const LoxString *a, const HashedString &b) const
+        {
+            return a->AsString() == b.mString;
+        }
+    };
+
+    void Register(Obj *object, uint32_t size)
+    {
+        object->mSize = size;
+        object->mNext = mObjects;
+        mObjects = object;
+
+        mStats.mObjectsAllocated++;
+        Charge(size);
+    }
+    void Resize(Obj *object, size_t size)
+    {
+        size = std::min<size_t>(size, UINT32_MAX);
+        if (size > object->mSize)
+            Charge(size - object->mSize);
+        else
+        {
+            mBytes -= object->mSize - size;
+            mStats.mBytesFreed += object->mSize - size;
+        }
+        object->mSize = static_cast<uint32_t>(size);
+    }
+    void Charge(size_t size)
+    {
+        mBytes += size;
+        mStats.mBytesAllocated += size;
+        if (mBytes > mStats.mPeakBytes)
+            mStats.mPeakBytes = mBytes;
+    }
+    LoxString *AddString(LoxString *str)
+    {
+        // the characters count too, or long strings would never make the heap collect
+        Register(str, static_cast<uint32_t>(sizeof(LoxString) + str->AsString().capacity()));
+        mStrings.insert(str);
+        return str;
+    }
+    void Sweep();
+
+    GcConfig mConfig;
+    GcStats mStats;
+
+    Obj *mObjects = nullptr;
+    // every string of this heap; it does not keep them alive, Sweep drops the ones it frees
+    std::unordered_set<LoxString *, StringSetHasher, StringSetEqual> mStrings;
+    vector<Obj *> mGray;
+    size_t mBytes = 0;
+    size_t mNextGc;
+};
+
+} // namespace lox
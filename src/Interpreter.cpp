@@ -1,28 +1,35 @@
 #include "Interpreter.h"
 #include "Lox.h"
+#include "LoxCell.h"
 #include "LoxClass.h"
 #include "LoxFunction.h"
+#include "LoxList.h"
+#include "LoxMap.h"
+#include "LoxRope.h"
+#include "LoxNative.h"
 
 namespace lox
 {
 
-using std::addressof;
 using std::make_shared;
 
 Interpreter::Interpreter() : Interpreter(std::cout)
 {
 }
 
-Interpreter::Interpreter(std::ostream &os) : mGlobals(make_shared<Environment>()), mEnvironment(mGlobals), mOs(os)
+Interpreter::Interpreter(std::ostream &os) : Interpreter(os, GcConfig())
 {
 }
 
-template <typename T, typename V> shared_ptr<Value> LoxValue(const V &value)
+Interpreter::Interpreter(std::ostream &os, const GcConfig &gcConfig)
+    : mHeap(gcConfig), mStack(STACK_INITIAL_SIZE), mOs(os)
 {
-    return make_shared<T>(value);
+    for (auto &native : Natives())
+        mGlobals.Define(mGlobals.Slot(native.mName),
+                        Value(mHeap.New<LoxNative>(native.mName, native.mArity, native.mFunction)));
 }
 
-void Interpreter::Interpret(const vector<shared_ptr<Stmt>> &stmts)
+void Interpreter::Interpret(const vector<Stmt *> &stmts)
 {
     try
     {
@@ -33,196 +40,350 @@ void Interpreter::Interpret(const vector<shared_ptr<Stmt>> &stmts)
     {
         Lox::ErrorRuntimeError(e);
     }
+    // the error may have left a call running, and the locals of top level blocks are dead now either way
+    LeaveFrame(Frame{0, 0, nullptr});
 }
 
-void Interpreter::Visit(const Expression &stmt)
+Completion Interpreter::Visit(const Expression &stmt)
 {
     Evaluate(*stmt.mExpression);
+    return Completion();
 }
 
-void Interpreter::Visit(const Print &stmt)
+Completion Interpreter::Visit(const Print &stmt)
 {
     auto value = Evaluate(*stmt.mExpression);
-    Println(value ? value->Str() : "nil");
+    Println(value.Str());
+    return Completion();
 }
 
-void Interpreter::Visit(const Var &stmt)
+Completion Interpreter::Visit(const Var &stmt)
 {
-    auto value = stmt.mInitializer ? Evaluate(*stmt.mInitializer) : nullptr;
-    mEnvironment->Define(stmt.mName->Lexeme(), value);
+    auto value = stmt.mInitializer ? Evaluate(*stmt.mInitializer) : Value();
+    Declare(stmt.mName, stmt.mSlot, value);
+    return Completion();
 }
 
-void Interpreter::Visit(const Block &stmt)
+Completion Interpreter::Visit(const Block &stmt)
 {
-    auto newEnvironment = make_shared<Environment>(mEnvironment);
-    ExecuteBlock(stmt.mStatements, newEnvironment);
+    // the locals of the block have slots in the running frame
+    return ExecuteBlock(stmt.mStatements);
 }
 
-void Interpreter::Visit(const If &stmt)
+Completion Interpreter::Visit(const If &stmt)
 {
     if (IsTruthy(Evaluate(*stmt.mCondition)))
-        Execute(*stmt.mThenBranch);
+        return Execute(*stmt.mThenBranch);
     else if (stmt.mElseBranch)
-        Execute(*stmt.mElseBranch);
+        return Execute(*stmt.mElseBranch);
+    return Completion();
 }
 
-void Interpreter::Visit(const While &stmt)
+Completion Interpreter::Visit(const While &stmt)
 {
     while (IsTruthy(Evaluate(*stmt.mCondition)))
-        Execute(*stmt.mBody);
+    {
+        auto completion = Execute(*stmt.mBody);
+        if (completion.mType != COMPLETION_NORMAL)
+            return completion;
+    }
+    return Completion();
 }
 
-void Interpreter::Visit(const Function &stmt)
+Completion Interpreter::Visit(const Function &stmt)
 {
-    auto function = make_shared<LoxFunction>(stmt, mEnvironment, false);
-    mEnvironment->Define(stmt.mName->Lexeme(), function);
+    // a function referring to itself captures its own cell, which has to exist before the closure
+    DeclareCell(stmt.mSlot);
+    auto function = Value(NewClosure(&stmt, FUNCTION_FUNCTION));
+    Define(stmt.mName, stmt.mSlot, function);
+    return Completion();
 }
 
-void Interpreter::Visit(const Return &stmt)
+Completion Interpreter::Visit(const Return &stmt)
 {
-    auto value = stmt.mValue ? Evaluate(*stmt.mValue) : nullptr;
+    auto value = stmt.mValue ? Evaluate(*stmt.mValue) : Value();
 
-    throw FunctionReturn(value);
+    return Completion{COMPLETION_RETURN, value};
 }
 
-void Interpreter::Visit(const Class &stmt)
+Completion Interpreter::Visit(const Class &stmt)
 {
-    shared_ptr<Value> superclass = nullptr;
+    Value superclass;
     if (stmt.mSuperclass)
     {
         superclass = Evaluate(*stmt.mSuperclass);
-        if (!superclass->IsClass())
+        if (!superclass.IsClass())
             throw RuntimeError(*stmt.mSuperclass->mName, "Superclass must be a class.");
     }
 
-    mEnvironment->Define(stmt.mName->Lexeme(), nullptr);
-
+    // the methods capture the cells of the class name and of "super" before the class exists
+    DeclareCell(stmt.mSlot);
     if (stmt.mSuperclass)
-    {
-        mEnvironment = make_shared<Environment>(mEnvironment);
-        mEnvironment->Define("super", superclass);
-    }
+        DeclareCell(stmt.mSuperSlot);
 
-    unordered_map<string, shared_ptr<LoxFunction>> methods;
+    StringMap<Value> methods;
     for (auto method : stmt.mMethods)
     {
-        auto function = make_shared<LoxFunction>(*method, mEnvironment, method->mName->Lexeme() == "init");
-        methods[method->mName->Lexeme()] = function;
+        auto type = method->mName->Lexeme() == "init" ? FUNCTION_INITIALIZER : FUNCTION_METHOD;
+        methods[method->mName->Lexeme()] = Value(NewClosure(method, type));
     }
 
-    // TODO superclass
-    auto klass =
-        make_shared<LoxClass>(stmt.mName->Lexeme(), superclass ? &superclass->AsClass() : nullptr, std::move(methods));
+    auto klass = Value(mHeap.New<LoxClass>(stmt.mName->Lexeme(), superclass.IsNil() ? nullptr : &superclass.AsClass(),
+                                    std::move(methods)));
 
-    if (superclass)
-        mEnvironment = mEnvironment->GetEnclosing();
+    if (!superclass.IsNil())
+    {
+        klass.AsClass().ResolveSuperMethods(stmt.mSuperMethods);
+        Define(stmt.mName, stmt.mSuperSlot, klass);
+    }
 
-    mEnvironment->Assign(stmt.mName, klass);
+    Define(stmt.mName, stmt.mSlot, klass);
+    return Completion();
 }
 
-shared_ptr<Value> Interpreter::Visit(const Assign &expr)
+Value Interpreter::Visit(const Assign &expr)
 {
     auto value = Evaluate(*expr.mValue);
 
-    if (mLocals.contains(addressof(expr)))
-        mEnvironment->AssignAt(mLocals.at(addressof(expr)), expr.mName, value);
-    else
-        mGlobals->Assign(expr.mName, value);
+    if (expr.mSlot.IsResolved())
+    {
+        Resolved(expr.mSlot) = value;
+        return value;
+    }
+
+    auto slot = GlobalSlot(expr.mName, expr.mGlobal);
+    if (!mGlobals.IsDefined(slot))
+        throw RuntimeError(*expr.mName, "Undefined variable '" + expr.mName->Lexeme() + "'.");
+    mGlobals.Set(slot, value);
 
     return value;
 }
 
-shared_ptr<Value> Interpreter::Visit(const Binary &expr)
+Value Interpreter::Visit(const Binary &expr)
 {
+    RootScope roots(*this);
     auto left = Evaluate(*expr.mLeft);
+    roots.Add(left);
     auto right = Evaluate(*expr.mRight);
 
     switch (expr.mOp->Type())
     {
         /* equality */
     case TOKEN_BANG_EQUAL:
-        return LoxValue<BooleanValue>(!IsEqual(left, right));
+        return Value(!IsEqual(left, right));
     case TOKEN_EQUAL_EQUAL:
-        return LoxValue<BooleanValue>(IsEqual(left, right));
+        return Value(IsEqual(left, right));
         /* comparison */
     case TOKEN_GREATER:
         CheckNumberOperands(expr.mOp, left, right);
-        return LoxValue<BooleanValue>(left->AsNumber() > right->AsNumber());
+        return Value(left.AsNumber() > right.AsNumber());
     case TOKEN_GREATER_EQUAL:
         CheckNumberOperands(expr.mOp, left, right);
-        return LoxValue<BooleanValue>(left->AsNumber() >= right->AsNumber());
+        return Value(left.AsNumber() >= right.AsNumber());
     case TOKEN_LESS:
         CheckNumberOperands(expr.mOp, left, right);
-        return LoxValue<BooleanValue>(left->AsNumber() < right->AsNumber());
+        return Value(left.AsNumber() < right.AsNumber());
     case TOKEN_LESS_EQUAL:
         CheckNumberOperands(expr.mOp, left, right);
-        return LoxValue<BooleanValue>(left->AsNumber() <= right->AsNumber());
+        return Value(left.AsNumber() <= right.AsNumber());
         /* arithmetic (& string) */
     case TOKEN_MINUS:
         CheckNumberOperands(expr.mOp, left, right);
-        return LoxValue<NumberValue>(left->AsNumber() - right->AsNumber());
+        return Value(left.AsNumber() - right.AsNumber());
     case TOKEN_PLUS:
-        if (left->IsNumber() && right->IsNumber())
+        if (left.IsNumber() && right.IsNumber())
         {
-            return LoxValue<NumberValue>(left->AsNumber() + right->AsNumber());
+            return Value(left.AsNumber() + right.AsNumber());
         }
-        else if (left->IsString() && right->IsString())
+        else if (LoxRope::IsText(left) && LoxRope::IsText(right))
         {
-            return LoxValue<StringValue>(left->AsString() + right->AsString());
+            // a short result cannot have a rope operand
+            if (LoxRope::Length(left) + LoxRope::Length(right) < LoxRope::MIN_LENGTH)
+                return Value(mHeap.Intern(left.AsString() + right.AsString()));
+            return Value(mHeap.New<LoxRope>(left, right));
         }
         throw RuntimeError(*expr.mOp, "Operands must be two numbers or two strings.");
     case TOKEN_SLASH:
         CheckNumberOperands(expr.mOp, left, right);
-        return LoxValue<NumberValue>(left->AsNumber() / right->AsNumber());
+        return Value(left.AsNumber() / right.AsNumber());
     case TOKEN_STAR:
         CheckNumberOperands(expr.mOp, left, right);
-        return LoxValue<NumberValue>(left->AsNumber() * right->AsNumber());
+        return Value(left.AsNumber() * right.AsNumber());
     default:
-        return nullptr;
+        return Value();
     }
-    return nullptr;
+    return Value();
 }
 
-shared_ptr<Value> Interpreter::Visit(const Call &expr)
+Value Interpreter::Visit(const Call &expr)
 {
+    if (typeid(*expr.mCallee) == typeid(Get))
+        return Invoke(static_cast<const Get &>(*expr.mCallee), expr);
+    if (typeid(*expr.mCallee) == typeid(Super))
+        return InvokeSuper(static_cast<const Super &>(*expr.mCallee), expr);
+
+    RootScope roots(*this);
     auto callee = Evaluate(*expr.mCallee);
+    roots.Add(callee);
 
-    vector<shared_ptr<Value>> arguments;
-    for (auto argument : expr.mArguments)
-        arguments.push_back(Evaluate(*argument));
+    auto top = mStackTop;
+    auto result = CallValue(expr, callee, PushArguments(expr));
+    mStackTop = top;
+    return result;
+}
 
-    if (!callee->IsCallable())
-        throw RuntimeError(*expr.mParen, "Can only call functions and classes.");
+// obj.method(args) calls the method with obj as its receiver, no bound method is created
+Value Interpreter::Invoke(const Get &get, const Call &expr)
+{
+    RootScope roots(*this);
+    auto object = Evaluate(*get.mObject);
+    if (!object.IsInstance())
+        throw RuntimeError(*get.mName, "Only instances have properties.");
+    roots.Add(object);
 
-    auto callable = callee->AsCallable();
+    auto &instance = object.AsInstance();
+    auto property = instance.Resolve(*get.mName, get.mSite);
+    auto top = mStackTop;
+    Value result;
+    if (property.mSlot >= 0)
+    {
+        auto callee = instance.SlotAt(property.mSlot);
+        roots.Add(callee);
+        result = CallValue(expr, callee, PushArguments(expr));
+    }
+    else
+    {
+        auto &method = property.mMethod->AsFunction();
+        auto arguments = PushArguments(expr);
+        CheckArity(expr, method.Arity(), arguments);
+        result = method.Invoke(*this, object, arguments);
+    }
+    mStackTop = top;
+    return result;
+}
+
+// super.method(args) calls the method with "this" as its receiver, no bound method is created
+Value Interpreter::InvokeSuper(const Super &super, const Call &expr)
+{
+    auto &method = SuperMethod(super);
+    auto object = Resolved(super.mReceiver);
 
-    if (arguments.size() != callable->Arity())
-        throw RuntimeError(*expr.mParen, "Expected " + to_string(callable->Arity()) + " arguments but got " +
+    auto top = mStackTop;
+    auto arguments = PushArguments(expr);
+    CheckArity(expr, method.Arity(), arguments);
+    auto result = method.Invoke(*this, object, arguments);
+    mStackTop = top;
+    return result;
+}
+
+// A free slot is left in front of the arguments, so that a LoxFunction can make them the first slots of its frame
+// with the receiver right before them.
+Arguments Interpreter::PushArguments(const Call &expr)
+{
+    auto base = mStackTop;
+    GrowStack(base + 1 + expr.mArguments.size());
+    mStack[mStackTop++] = Value();
+    for (auto argument : expr.mArguments)
+    {
+        // evaluating an argument may grow the stack, so the value is stored once it is known
+        auto value = Evaluate(*argument);
+        mStack[mStackTop++] = value;
+    }
+    return Arguments(mStack.data() + base + 1, expr.mArguments.size());
+}
+
+void Interpreter::CheckArity(const Call &expr, size_t arity, const Arguments &arguments) const
+{
+    if (arguments.size() != arity)
+        throw RuntimeError(*expr.mParen, "Expected " + to_string(arity) + " arguments but got " +
                                              to_string(arguments.size()) + ".");
+}
+
+Value Interpreter::CallValue(const Call &expr, const Value &callee, Arguments arguments)
+{
+    if (!callee.IsCallable())
+        throw RuntimeError(*expr.mParen, "Can only call functions and classes.");
 
+    auto callable = callee.AsCallable();
+    CheckArity(expr, callable->Arity(), arguments);
+
+    if (callable->Kind() == OBJ_KIND_NATIVE)
+        return InvokeNative(expr, static_cast<LoxNative &>(*callable), arguments.data());
     return callable->Call(*this, arguments);
 }
 
-shared_ptr<Value> Interpreter::Visit(const Get &expr)
+Value Interpreter::InvokeNative(const Call &expr, const LoxNative &native, const Value *args)
+{
+    try
+    {
+        return native.Invoke(mHeap, args);
+    }
+    catch (const NativeError &error)
+    {
+        throw RuntimeError(*expr.mParen, error.mMsg);
+    }
+}
+
+Value Interpreter::Visit(const Get &expr)
 {
     auto object = Evaluate(*expr.mObject);
-    if (object->IsInstance())
-        return object->AsInstance().Get(*expr.mName);
+    if (object.IsInstance())
+        return object.AsInstance().Get(mHeap, *expr.mName, expr.mSite);
 
     throw RuntimeError(*expr.mName, "Only instances have properties.");
 }
 
-shared_ptr<Value> Interpreter::Visit(const Grouping &expr)
+Value Interpreter::Visit(const Grouping &expr)
 {
     return Evaluate(*expr.mExpression);
 }
 
-shared_ptr<Value> Interpreter::Visit(const Literal &expr)
+Value Interpreter::Visit(const Index &expr)
 {
-    return InterpretObject(expr.mValue);
+    RootScope roots(*this);
+    auto object = Evaluate(*expr.mObject);
+    roots.Add(object);
+    auto index = Evaluate(*expr.mIndex);
+
+    if (object.IsMap())
+    {
+        index = LoxRope::Flatten(mHeap, index);
+        if (auto error = LoxMap::CheckKey(index))
+            throw RuntimeError(*expr.mBracket, error);
+        // a missing key reads as nil
+        Value value;
+        object.AsMap().Get(index, value);
+        return value;
+    }
+
+    if (!object.IsList())
+        throw RuntimeError(*expr.mBracket, "Only lists and maps can be indexed.");
+
+    auto &list = object.AsList();
+    size_t position;
+    if (auto error = list.CheckIndex(index, position))
+        throw RuntimeError(*expr.mBracket, error);
+    return list.At(position);
 }
 
-shared_ptr<Value> Interpreter::Visit(const Logical &expr)
+Value Interpreter::Visit(const ListLiteral &expr)
+{
+    RootScope roots(*this);
+    auto base = mTempRoots.size();
+    for (auto element : expr.mElements)
+        roots.Add(Evaluate(*element));
+
+    return Value(mHeap.New<LoxList>(mTempRoots.data() + base, expr.mElements.size()));
+}
+
+Value Interpreter::Visit(const Literal &expr)
+{
+    if (expr.mValue->Type() == OBJ_TEXT)
+        return Value(LiteralString(*expr.mValue, expr.mSite));
+    return InterpretObject(*expr.mValue);
+}
+
+Value Interpreter::Visit(const Logical &expr)
 {
     auto left = Evaluate(*expr.mLeft);
 
@@ -240,160 +401,322 @@ shared_ptr<Value> Interpreter::Visit(const Logical &expr)
     return Evaluate(*expr.mRight);
 }
 
-shared_ptr<Value> Interpreter::Visit(const Set &expr)
+Value Interpreter::Visit(const MapLiteral &expr)
+{
+    RootScope roots(*this);
+    auto map = mHeap.New<LoxMap>();
+    roots.Add(Value(map));
+    for (size_t i = 0; i < expr.mKeys.size(); i++)
+    {
+        auto key = LoxRope::Flatten(mHeap, Evaluate(*expr.mKeys[i]));
+        if (auto error = LoxMap::CheckKey(key))
+            throw RuntimeError(*expr.mBrace, error);
+        roots.Add(key);
+        map->Set(mHeap, key, Evaluate(*expr.mValues[i]));
+    }
+    return Value(map);
+}
+
+Value Interpreter::Visit(const Set &expr)
 {
+    RootScope roots(*this);
     auto object = Evaluate(*expr.mObject);
 
-    if (!object->IsInstance())
+    if (!object.IsInstance())
         throw RuntimeError(*expr.mName, "Only instances have fields.");
 
+    roots.Add(object);
     auto value = Evaluate(*expr.mValue);
-    object->AsInstance().Set(*expr.mName, value);
+    object.AsInstance().Set(*expr.mName, value, expr.mSite);
     return value;
 }
 
-shared_ptr<Value> Interpreter::Visit(const Super &expr)
+Value Interpreter::Visit(const SetIndex &expr)
 {
-    auto distance = mLocals.at(addressof(expr));
+    RootScope roots(*this);
+    auto object = Evaluate(*expr.mObject);
+    roots.Add(object);
+    auto index = Evaluate(*expr.mIndex);
+    roots.Add(index);
+    auto value = Evaluate(*expr.mValue);
+
+    if (object.IsMap())
+    {
+        index = LoxRope::Flatten(mHeap, index);
+        if (auto error = LoxMap::CheckKey(index))
+            throw RuntimeError(*expr.mBracket, error);
+        object.AsMap().Set(mHeap, index, value);
+        return value;
+    }
 
-    auto superclass = mEnvironment->GetAt(distance, "super")->AsClass();
+    if (!object.IsList())
+        throw RuntimeError(*expr.mBracket, "Only lists and maps can be indexed.");
 
-    auto object = mEnvironment->GetAt(distance - 1, "this");
+    auto &list = object.AsList();
+    size_t position;
+    if (auto error = list.CheckIndex(index, position))
+        throw RuntimeError(*expr.mBracket, error);
+    list.At(position) = value;
+    return value;
+}
+
+Value Interpreter::Visit(const Super &expr)
+{
+    return SuperMethod(expr).Bind(mHeap, &Resolved(expr.mReceiver).AsInstance());
+}
 
-    auto method = superclass.FindMethod(expr.mMethod->Lexeme());
+// the method the class resolved for a super expression when it was created
+LoxFunction &Interpreter::SuperMethod(const Super &expr)
+{
+    // "super" holds the class the method belongs to
+    auto &klass = Resolved(expr.mSlot).AsClass();
 
-    if (!method)
+    // the resolver numbers every super expression it accepts
+    if (expr.mTarget < 0)
+        throw RuntimeError(*expr.mKeyword, "Unresolved 'super' expression.");
+    auto &method = klass.SuperMethod(expr.mTarget);
+    if (method.IsNil())
         throw RuntimeError(*expr.mMethod, "Undefined property '" + expr.mMethod->Lexeme() + "'.");
-
-    return method->AsFunction().Bind(static_pointer_cast<LoxInstance>(object)); // TODO
+    return method.AsFunction();
 }
 
-shared_ptr<Value> Interpreter::Visit(const This &expr)
+Value Interpreter::Visit(const This &expr)
 {
-    return LookUpVariable(expr.mKeyword, expr);
+    // "this" only appears in methods, so it is always resolved
+    return Resolved(expr.mSlot);
 }
 
-shared_ptr<Value> Interpreter::Visit(const Unary &expr)
+Value Interpreter::Visit(const Unary &expr)
 {
     auto right = Evaluate(*expr.mRight);
 
     switch (expr.mOp->Type())
     {
     case TOKEN_BANG:
-        return LoxValue<BooleanValue>(!IsTruthy(right));
+        return Value(!IsTruthy(right));
     case TOKEN_MINUS:
         CheckNumberOperand(expr.mOp, right);
-        return LoxValue<NumberValue>(-1 * right->AsNumber());
+        return Value(-1 * right.AsNumber());
     default:
         throw std::runtime_error("[ERROR on Visit(Unary)] Illegal op type: " + to_string(expr.mOp->Type()));
     }
-    return nullptr; // Unreachable.
+    return Value(); // Unreachable.
 }
 
-shared_ptr<Value> Interpreter::Visit(const Variable &expr)
+Value Interpreter::Visit(const Variable &expr)
 {
-    return LookUpVariable(expr.mName, expr);
+    return LookUpVariable(expr.mName, expr.mSlot, expr.mGlobal);
 }
 
-void Interpreter::Resolve(const Expr &expr, int depth)
+Completion Interpreter::Execute(const Stmt &stmt)
 {
-    mLocals[addressof(expr)] = depth;
+    // statement boundaries are the only points where the interpreter collects
+    if (mHeap.ShouldCollect())
+        CollectGarbage();
+
+    return stmt.Accept(*this);
 }
 
-void Interpreter::Execute(const Stmt &stmt)
+void Interpreter::DeclareCell(const Slot &slot)
 {
-    stmt.Accept(*this);
+    if (slot.mKind == SLOT_CELL)
+        DeclaredLocal(slot.mIndex) = Value(mHeap.New<LoxCell>(Value()));
 }
 
-void Interpreter::ExecuteBlock(const vector<shared_ptr<Stmt>> &stmts, const shared_ptr<Environment> &environment)
+void Interpreter::Define(const Token *name, const Slot &slot, const Value &value)
 {
-    auto previous = mEnvironment;
-    try
+    switch (slot.mKind)
     {
-        mEnvironment = environment;
-        for (auto stmt : stmts)
-            Execute(*stmt);
+    case SLOT_LOCAL:
+        DeclaredLocal(slot.mIndex) = value;
+        break;
+    case SLOT_CELL:
+        Resolved(slot) = value;
+        break;
+    default:
+        mGlobals.Define(mGlobals.Slot(name->Name()), value);
     }
-    catch (const FunctionReturn &returnValue)
+}
+
+// the closure gets the cells of the frame creating it, or of the closure running it, that its declaration captures
+LoxFunction *Interpreter::NewClosure(const Function *declaration, FunctionType type)
+{
+    vector<LoxCell *> upvalues;
+    upvalues.reserve(declaration->mFrame.mUpvalues.size());
+    for (auto &capture : declaration->mFrame.mUpvalues)
     {
-        // TODO fix
-        mEnvironment = previous;
-        throw returnValue;
+        upvalues.push_back(capture.mIsLocal ? static_cast<LoxCell *>(Local(capture.mIndex).AsObj())
+                                            : mFunction->Upvalue(capture.mIndex));
     }
-    mEnvironment = previous;
+    return mHeap.New<LoxFunction>(declaration, std::move(upvalues), type);
 }
 
-shared_ptr<Value> Interpreter::Evaluate(const Expr &expr)
+Completion Interpreter::ExecuteBlock(const vector<Stmt *> &stmts)
+{
+    for (auto &stmt : stmts)
+    {
+        auto completion = Execute(*stmt);
+        if (completion.mType != COMPLETION_NORMAL)
+            return completion;
+    }
+    return Completion();
+}
+
+Interpreter::Frame Interpreter::EnterFrame(LoxFunction *function, Arguments arguments, bool hasReceiver, int size)
+{
+    Frame caller{mFrameBase, mStackTop, mFunction};
+
+    auto params = PlaceArguments(arguments);
+    mFrameBase = hasReceiver ? params - 1 : params;
+    params += arguments.size();
+    mStackTop = mFrameBase + size;
+    GrowStack(mStackTop);
+    // slots are cleared so that the collector never sees values the previous user of the slots left behind
+    std::fill(mStack.begin() + params, mStack.begin() + mStackTop, Value());
+    mFunction = function;
+
+    return caller;
+}
+
+// The stack index of the arguments, with a free slot in front of them. Arguments on top of the stack come from
+// PushArguments and are used where they are, anything else is copied there first.
+size_t Interpreter::PlaceArguments(Arguments arguments)
+{
+    auto pushed = mStackTop - arguments.size();
+    if (mStackTop > arguments.size() && arguments.data() == mStack.data() + pushed)
+        return pushed;
+
+    // such arguments never point into the stack, which growing it could move
+    auto index = mStackTop + 1;
+    GrowStack(index + arguments.size());
+    mStack[index - 1] = Value();
+    std::copy(arguments.begin(), arguments.end(), mStack.begin() + index);
+    return index;
+}
+
+Value &Interpreter::DeclaredLocal(int index)
+{
+    auto slot = mFrameBase + index;
+    if (slot >= mStackTop)
+    {
+        mStackTop = slot + 1;
+        GrowStack(mStackTop);
+    }
+    return mStack[slot];
+}
+
+Value Interpreter::Evaluate(const Expr &expr)
 {
     return expr.Accept(*this);
 }
 
 // false and nil are falsey and everything else is truthy
-bool Interpreter::IsTruthy(const shared_ptr<Value> &value) const
+bool Interpreter::IsTruthy(const Value &value) const
 {
-    if (!value)
+    if (value.IsNil())
         return false;
-    if (value->IsBoolean())
-        return value->AsBoolean();
+    if (value.IsBoolean())
+        return value.AsBoolean();
     return true;
 }
 
-bool Interpreter::IsEqual(const shared_ptr<Value> &left, const shared_ptr<Value> &right) const
+bool Interpreter::IsEqual(const Value &left, const Value &right)
 {
-    if (left == nullptr && right == nullptr)
-        return true;
-    if (left == nullptr)
-        return false;
-    return left->Equals(*right);
+    // once flattened, comparing the same ropes again is an identity check
+    return LoxRope::Flatten(mHeap, left).Equals(LoxRope::Flatten(mHeap, right));
 }
 
-void Interpreter::CheckNumberOperand(const shared_ptr<Token> op, const shared_ptr<Value> &operand) const
+void Interpreter::CheckNumberOperand(const Token *op, const Value &operand) const
 {
-    if (operand->IsNumber())
+    if (operand.IsNumber())
         return;
     throw RuntimeError(*op, "Operand must be a number.");
 }
 
-void Interpreter::CheckNumberOperands(const shared_ptr<Token> op, const shared_ptr<Value> &left,
-                                      const shared_ptr<Value> &right) const
+void Interpreter::CheckNumberOperands(const Token *op, const Value &left, const Value &right) const
 {
-    if (left->IsNumber() && right->IsNumber())
+    if (left.IsNumber() && right.IsNumber())
         return;
     throw RuntimeError(*op, "Operands must be numbers.");
 }
 
-shared_ptr<Value> Interpreter::LookUpVariable(const shared_ptr<Token> &name, const Expr &expr) const
+Value Interpreter::LookUpVariable(const Token *name, const Slot &slot, GlobalSite &site)
+{
+    if (slot.IsResolved())
+        return Resolved(slot);
+
+    auto global = GlobalSlot(name, site);
+    if (!mGlobals.IsDefined(global))
+        throw RuntimeError(*name, "Undefined variable '" + name->Lexeme() + "'.");
+    return mGlobals.Get(global);
+}
+
+Value &Interpreter::Resolved(const Slot &slot)
 {
-    if (mLocals.contains(addressof(expr)))
-        return mEnvironment->GetAt(mLocals.at(addressof(expr)), name->Lexeme());
-    return mGlobals->Get(name);
+    switch (slot.mKind)
+    {
+    case SLOT_LOCAL:
+        return Local(slot.mIndex);
+    case SLOT_CELL:
+        return static_cast<LoxCell *>(Local(slot.mIndex).AsObj())->Get();
+    default:
+        return mFunction->Upvalue(slot.mIndex)->Get();
+    }
+}
+
+// the name is hashed once per site, every later run of the site indexes the table directly
+int Interpreter::GlobalSlot(const Token *name, GlobalSite &site)
+{
+    if (site.mSlot < 0)
+        site.mSlot = mGlobals.Slot(name->Name());
+    return site.mSlot;
 }
 
-shared_ptr<Value> Interpreter::InterpretObject(const Object &object) const
+// the string is interned once per literal, every later run of the literal reuses it
+LoxString *Interpreter::LiteralString(const Object &object, StringSite &site)
+{
+    if (!site.mString)
+    {
+        site.mString = mHeap.Intern(object.Text());
+        mLiteralStrings.push_back(site.mString);
+    }
+    return site.mString;
+}
+
+Value Interpreter::InterpretObject(const Object &object)
 {
     switch (object.Type())
     {
     case OBJ_NIL:
-        return nullptr;
+        return Value();
     case OBJ_TEXT:
-        return LoxValue<StringValue>(object.Text());
+        return Value(mHeap.Intern(object.Text()));
     case OBJ_NUMBER:
-        return LoxValue<NumberValue>(object.Number());
+        return Value(object.Number());
     case OBJ_BOOL:
-        return LoxValue<BooleanValue>(object.Bool());
+        return Value(object.Bool());
     default:
         throw std::runtime_error("[ERROR on InterpretObject] Illegal object type: " + to_string(object.Type()));
     }
 }
 
-shared_ptr<Value> Interpreter::InterpretObject(const shared_ptr<Object> &object) const
+void Interpreter::Println(const string &str) const
 {
-    return InterpretObject(*object);
+    mOs << str << std::endl;
 }
 
-void Interpreter::Println(const string &str) const
+void Interpreter::CollectGarbage()
 {
-    mOs << str << std::endl;
+    mHeap.Collect([this](Heap &heap) {
+        mGlobals.Trace(heap);
+        for (size_t i = 0; i < mStackTop; i++)
+            heap.Mark(mStack[i]);
+        heap.Mark(mFunction);
+        for (auto string : mLiteralStrings)
+            heap.Mark(string);
+        for (auto &value : mTempRoots)
+            heap.Mark(value);
+    });
 }
 
 }; // namespace lox
@@ -1,10 +1,12 @@
 #pragma once
 
-#include "Environment.h"
 #include "Expr.h"
+#include "GlobalTable.h"
+#include "Heap.h"
 #include "LoxCallable.h"
 #include "Stmt.h"
 #include "Value.h"
+#include <algorithm>
 #include <iostream>
 #include <memory>
 
@@ -31,68 +33,171 @@ class RuntimeError : public exception
     const string mMsg;
 };
 
-class Interpreter : public Expr::Visitor<shared_ptr<Value>>, public Stmt::Visitor<void>
+class LoxNative;
+class RootScope;
+
+class Interpreter : public Expr::Visitor<Value>, public Stmt::Visitor<Completion>
 {
     friend class LoxFunction;
+    friend class RootScope;
 
   public:
     Interpreter();
     Interpreter(std::ostream &os);
-
-    void Interpret(const vector<shared_ptr<Stmt>> &stmts);
-
-    void Visit(const Expression &stmt);
-    void Visit(const Print &stmt);
-    void Visit(const Var &stmt);
-    void Visit(const Block &stmt);
-    void Visit(const If &stmt);
-    void Visit(const While &stmt);
-    void Visit(const Function &stmt);
-    void Visit(const Return &stmt);
-    void Visit(const Class &stmt);
-
-    shared_ptr<Value> Visit(const Assign &expr);
-    shared_ptr<Value> Visit(const Binary &expr);
-    shared_ptr<Value> Visit(const Call &expr);
-    shared_ptr<Value> Visit(const Get &expr);
-    shared_ptr<Value> Visit(const Grouping &expr);
-    shared_ptr<Value> Visit(const Literal &expr);
-    shared_ptr<Value> Visit(const Logical &expr);
-    shared_ptr<Value> Visit(const Set &expr);
-    shared_ptr<Value> Visit(const Super &expr);
-    shared_ptr<Value> Visit(const This &expr);
-    shared_ptr<Value> Visit(const Unary &expr);
-    shared_ptr<Value> Visit(const Variable &expr);
-
-    void Resolve(const Expr &expr, int depth);
+    Interpreter(std::ostream &os, const GcConfig &gcConfig);
+
+    void Interpret(const vector<Stmt *> &stmts);
+
+    Completion Visit(const Expression &stmt);
+    Completion Visit(const Print &stmt);
+    Completion Visit(const Var &stmt);
+    Completion Visit(const Block &stmt);
+    Completion Visit(const If &stmt);
+    Completion Visit(const While &stmt);
+    Completion Visit(const Function &stmt);
+    Completion Visit(const Return &stmt);
+    Completion Visit(const Class &stmt);
+
+    Value Visit(const Assign &expr);
+    Value Visit(const Binary &expr);
+    Value Visit(const Call &expr);
+    Value Visit(const Get &expr);
+    Value Visit(const Grouping &expr);
+    Value Visit(const Index &expr);
+    Value Visit(const ListLiteral &expr);
+    Value Visit(const Literal &expr);
+    Value Visit(const Logical &expr);
+    Value Visit(const MapLiteral &expr);
+    Value Visit(const Set &expr);
+    Value Visit(const SetIndex &expr);
+    Value Visit(const Super &expr);
+    Value Visit(const This &expr);
+    Value Visit(const Unary &expr);
+    Value Visit(const Variable &expr);
+
+    Heap &GetHeap()
+    {
+        return mHeap;
+    }
+    const Heap &GetHeap() const
+    {
+        return mHeap;
+    }
 
     // for test
-    const Environment &CEnvironment() const
+    const GlobalTable &Globals() const
     {
-        return *mEnvironment;
+        return mGlobals;
     }
 
   private:
-    void Execute(const Stmt &stmt);
-    void ExecuteBlock(const vector<shared_ptr<Stmt>> &stmts, const shared_ptr<Environment> &environment);
-    shared_ptr<Value> Evaluate(const Expr &expr);
-    bool IsTruthy(const shared_ptr<Value> &value) const;
-    bool IsEqual(const shared_ptr<Value> &left, const shared_ptr<Value> &right) const;
-    void CheckNumberOperand(const shared_ptr<Token> op, const shared_ptr<Value> &operand) const;
-    void CheckNumberOperands(const shared_ptr<Token> op, const shared_ptr<Value> &left,
-                             const shared_ptr<Value> &right) const;
-    shared_ptr<Value> LookUpVariable(const shared_ptr<Token> &name, const Expr &expr) const;
-
-    shared_ptr<Value> InterpretObject(const shared_ptr<Object> &object) const;
-    shared_ptr<Value> InterpretObject(const Object &object) const;
+    static constexpr size_t STACK_INITIAL_SIZE = 256;
+
+    // the part of the stack a call runs in
+    struct Frame
+    {
+        size_t mBase;
+        size_t mTop;
+        LoxFunction *mFunction;
+    };
+
+    Completion Execute(const Stmt &stmt);
+    Completion ExecuteBlock(const vector<Stmt *> &stmts);
+    Value Evaluate(const Expr &expr);
+    Value Invoke(const Get &get, const Call &expr);
+    Value InvokeSuper(const Super &super, const Call &expr);
+    LoxFunction &SuperMethod(const Super &expr);
+    // evaluates the arguments of a call onto the stack, where they stay rooted until the call site pops them
+    Arguments PushArguments(const Call &expr);
+    void CheckArity(const Call &expr, size_t arity, const Arguments &arguments) const;
+    Value CallValue(const Call &expr, const Value &callee, Arguments arguments);
+    Value InvokeNative(const Call &expr, const LoxNative &native, const Value *args);
+    bool IsTruthy(const Value &value) const;
+    bool IsEqual(const Value &left, const Value &right);
+    // gives a captured variable a fresh cell, each run of its declaration declares a new variable
+    void DeclareCell(const Slot &slot);
+    // stores the initial value of a declared variable at the slot the Resolver gave it
+    void Define(const Token *name, const Slot &slot, const Value &value);
+    void Declare(const Token *name, const Slot &slot, const Value &value)
+    {
+        DeclareCell(slot);
+        Define(name, slot, value);
+    }
+    LoxFunction *NewClosure(const Function *declaration, FunctionType type);
+    void CheckNumberOperand(const Token *op, const Value &operand) const;
+    void CheckNumberOperands(const Token *op, const Value &left, const Value &right) const;
+    Value LookUpVariable(const Token *name, const Slot &slot, GlobalSite &site);
+    // where the value of a resolved variable is stored
+    Value &Resolved(const Slot &slot);
+    int GlobalSlot(const Token *name, GlobalSite &site);
+    LoxString *LiteralString(const Object &object, StringSite &site);
+
+    Value InterpretObject(const Object &object);
     void Println(const string &str) const;
 
-    shared_ptr<Environment> mGlobals;
-    shared_ptr<Environment> mEnvironment;
+    // makes the frame of a call to function the running one, and returns the frame of the caller.
+    // The frame starts with the receiver slot when there is one, followed by the arguments.
+    Frame EnterFrame(LoxFunction *function, Arguments arguments, bool hasReceiver, int size);
+    size_t PlaceArguments(Arguments arguments);
+    void GrowStack(size_t size)
+    {
+        if (size > mStack.size())
+            mStack.resize(std::max(size, 2 * mStack.size()));
+    }
+    void LeaveFrame(const Frame &caller)
+    {
+        mFrameBase = caller.mBase;
+        mStackTop = caller.mTop;
+        mFunction = caller.mFunction;
+    }
+    Value &Local(int index)
+    {
+        return mStack[mFrameBase + index];
+    }
+    // top level code has no call setting up its frame, its slots come into use as their declarations run
+    Value &DeclaredLocal(int index);
+
+    void CollectGarbage();
+
+    Heap mHeap;
+    // values only referenced from the C++ stack, see RootScope
+    vector<Value> mTempRoots;
 
-    unordered_map<const Expr *, int> mLocals;
+    GlobalTable mGlobals;
+    // the strings cached on Literal nodes, the AST does not keep them alive
+    vector<LoxString *> mLiteralStrings;
+
+    // the slots of the running calls, one frame after another. Only the cells of captured variables live on the heap.
+    vector<Value> mStack;
+    size_t mFrameBase = 0;
+    size_t mStackTop = 0;
+    // the closure whose frame is running, nullptr for top level code
+    LoxFunction *mFunction = nullptr;
 
     std::ostream &mOs;
 };
 
+// Keeps values that are only held by C++ locals alive while statements run, which is when collections happen.
+// Everything added is released again when the scope ends.
+class RootScope
+{
+  public:
+    RootScope(Interpreter &interpreter) : mRoots(interpreter.mTempRoots), mSize(mRoots.size())
+    {
+    }
+    ~RootScope()
+    {
+        mRoots.resize(mSize);
+    }
+
+    void Add(const Value &value)
+    {
+        mRoots.push_back(value);
+    }
+
+  private:
+    vector<Value> &mRoots;
+    size_t mSize;
+};
+
 } // namespace lox
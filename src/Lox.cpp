@@ -3,6 +3,7 @@
 #include "Parser.h"
 #include "Resolver.h"
 #include "Scanner.h"
+#include "VM.h"
 
 #include <fstream>
 #include <iostream>
@@ -31,17 +32,17 @@ string ReadFile(const string &fileName)
     return ss.str();
 }
 
-void Lox::DoInterpret(Interpreter &interpreter, const string &source)
+void Lox::DoInterpret(Interpreter &interpreter, const string &source, Arena &arena)
 {
-    Scanner s(source);
-    Parser p(s.ScanTokens());
+    Scanner s(source, arena);
+    Parser p(s.ScanTokens(), arena);
 
     auto stmts = p.Parse();
 
     if (sHadError)
         return;
 
-    Resolver r(interpreter);
+    Resolver r;
     r.Resolve(stmts);
 
     if (sHadError)
@@ -50,23 +51,59 @@ void Lox::DoInterpret(Interpreter &interpreter, const string &source)
     interpreter.Interpret(stmts);
 }
 
-void Lox::RunFile(const string &fileName)
+void Lox::DoInterpret(VM &vm, const string &source, Arena &arena)
 {
-    Interpreter interpreter;
+    Scanner s(source, arena);
+    Parser p(s.ScanTokens(), arena);
 
-    DoInterpret(interpreter, ReadFile(fileName));
+    auto stmts = p.Parse();
+
+    if (sHadError)
+        return;
+
+    // the compiler resolves locals itself, the resolver only reports static errors
+    Resolver r;
+    r.Resolve(stmts);
+
+    if (sHadError)
+        return;
+
+    vm.Interpret(stmts);
+}
+
+void Lox::RunFile(const string &fileName, Engine engine)
+{
+    RunFile(fileName, std::cout, engine);
 }
 
-void Lox::RunFile(const string &fileName, std::ostream &os)
+void Lox::RunFile(const string &fileName, std::ostream &os, Engine engine)
 {
-    Interpreter interpreter(os);
+    // declared first so the tree outlives the functions that point into it
+    Arena arena;
+
+    if (engine == ENGINE_VM)
+    {
+        VM vm(os, sGcConfig);
+        vm.SetDisassembly(sDisassemble ? &std::cerr : nullptr);
+        DoInterpret(vm, ReadFile(fileName), arena);
+        sGcStats = vm.GetHeap().Stats();
+        return;
+    }
+
+    Interpreter interpreter(os, sGcConfig);
 
-    DoInterpret(interpreter, ReadFile(fileName));
+    DoInterpret(interpreter, ReadFile(fileName), arena);
+    sGcStats = interpreter.GetHeap().Stats();
 }
 
-void Lox::RunRepl()
+void Lox::RunRepl(Engine engine)
 {
-    Interpreter interpreter;
+    // functions defined on earlier lines keep pointing into the tree, so the tree walker keeps every line.
+    // the VM compiles each line to bytecode and can drop its tree right away.
+    Arena arena;
+    Interpreter interpreter(std::cout, sGcConfig);
+    VM vm(std::cout, sGcConfig);
+    vm.SetDisassembly(sDisassemble ? &std::cerr : nullptr);
 
     bool isFirstLine = false;
     while (true)
@@ -85,7 +122,13 @@ void Lox::RunRepl()
         while (line.size() == 0)
             std::getline(std::cin, line);
 
-        DoInterpret(interpreter, line);
+        if (engine == ENGINE_VM)
+        {
+            DoInterpret(vm, line, arena);
+            arena.Release();
+        }
+        else
+            DoInterpret(interpreter, line, arena);
     }
 }
 
@@ -108,8 +151,13 @@ void Lox::Error(const Token &token, const string &message)
 
 void Lox::ErrorRuntimeError(const RuntimeError &error)
 {
-    std::cerr << error.mMsg << std::endl;
-    std::cerr << "[line " << error.mToken.Line() << "]" << std::endl;
+    ErrorRuntimeError(error.mToken.Line(), error.mMsg);
+}
+
+void Lox::ErrorRuntimeError(const int &line, const string &message)
+{
+    std::cerr << message << std::endl;
+    std::cerr << "[line " << line << "]" << std::endl;
     sHadError = true;
 }
 
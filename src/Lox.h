@@ -2,23 +2,49 @@
 
 #include <iostream>
 
+#include "Arena.h"
+#include "Heap.h"
 #include "Interpreter.h"
 #include "Token.h"
 
 namespace lox
 {
 
+enum Engine
+{
+    ENGINE_TREE_WALKER,
+    ENGINE_VM,
+};
+
+class VM;
+
 class Lox
 {
   public:
-    static void RunFile(const string &fileName);
-    static void RunFile(const string &fileName, std::ostream &os);
-    static void RunRepl();
+    static void RunFile(const string &fileName, Engine engine = ENGINE_TREE_WALKER);
+    static void RunFile(const string &fileName, std::ostream &os, Engine engine = ENGINE_TREE_WALKER);
+    static void RunRepl(Engine engine = ENGINE_TREE_WALKER);
 
     static void Error(const int &line, const string &message);
     static void Error(const Token &token, const string &message);
 
+    static void SetGcConfig(const GcConfig &config)
+    {
+        sGcConfig = config;
+    }
+    // lists the bytecode of what the VM runs to std::cerr
+    static void SetDisassemble(bool disassemble)
+    {
+        sDisassemble = disassemble;
+    }
+    // statistics of the heap used by the last RunFile
+    static const GcStats &LastGcStats()
+    {
+        return sGcStats;
+    }
+
     static void ErrorRuntimeError(const RuntimeError &error);
+    static void ErrorRuntimeError(const int &line, const string &message);
 
     /* for test */
     static bool HadError()
@@ -32,9 +58,13 @@ class Lox
 
   private:
     static void Report(const int &line, const string &where, const string &message);
-    static void DoInterpret(Interpreter &interpreter, const string &source);
+    static void DoInterpret(Interpreter &interpreter, const string &source, Arena &arena);
+    static void DoInterpret(VM &vm, const string &source, Arena &arena);
 
     inline static bool sHadError = false;
+    inline static GcConfig sGcConfig;
+    inline static bool sDisassemble = false;
+    inline static GcStats sGcStats;
 };
 
 } // namespace lox
@@ -3,25 +3,34 @@
 #include "Stmt.h"
 #include "Value.h"
 
+#include <span>
+
 namespace lox
 {
 
 class Interpreter;
 
-class LoxCallable : public Value
+// The arguments of a call, a view of values the caller owns. The tree walker evaluates them onto its stack, where a
+// LoxFunction runs its frame without copying them.
+using Arguments = std::span<const Value>;
+
+enum FunctionType
 {
-  public:
-    virtual size_t Arity() const = 0;
-    virtual shared_ptr<Value> Call(Interpreter &interpreter, const vector<shared_ptr<Value>> &arguments) = 0;
+    FUNCTION_NONE,
+    FUNCTION_FUNCTION,
+    FUNCTION_INITIALIZER,
+    FUNCTION_METHOD,
+};
 
-    LoxCallable *AsCallable() override
-    {
-        return this;
-    }
-    virtual const bool IsCallable() const override
+class LoxCallable : public Obj
+{
+  public:
+    LoxCallable(ObjKind kind) : Obj(kind)
     {
-        return true;
     }
+
+    virtual size_t Arity() const = 0;
+    virtual Value Call(Interpreter &interpreter, Arguments arguments) = 0;
 };
 
 } // namespace lox
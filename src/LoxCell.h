@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Heap.h"
+#include "Value.h"
+
+namespace lox
+{
+
+// A local variable that closures capture.
+// The frame declaring the variable holds the cell in the variable's slot and every closure capturing it holds the same
+// cell, so all of them see one value, which outlives the frame.
+class LoxCell : public Obj
+{
+  public:
+    LoxCell(const Value &value) : Obj(OBJ_KIND_CELL), mValue(value)
+    {
+    }
+
+    Value &Get()
+    {
+        return mValue;
+    }
+
+    virtual void Trace(Heap &heap) const override
+    {
+        heap.Mark(mValue);
+    }
+
+    virtual const string Str() const override
+    {
+        return "<cell>";
+    }
+
+  private:
+    Value mValue;
+};
+
+} // namespace lox
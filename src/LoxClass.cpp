@@ -5,49 +5,148 @@
 namespace lox
 {
 
-shared_ptr<Value> LoxClass::Call(Interpreter &interpreter, const vector<shared_ptr<Value>> &arguments)
+Value LoxClass::Call(Interpreter &interpreter, Arguments arguments)
 {
-    auto instance = make_shared<LoxInstance>(*this);
+    auto instance = Value(interpreter.GetHeap().New<LoxInstance>(this));
 
-    auto initializer = FindMethod("init");
-    if (initializer)
-        initializer->Bind(instance)->Call(interpreter, arguments);
+    // the instance goes straight into the frame of init, which is never bound
+    if (!mInitializer.IsNil())
+        mInitializer.AsFunction().Invoke(interpreter, instance, arguments);
 
     return instance;
 }
 
 size_t LoxClass::Arity() const
 {
-    auto initializer = FindMethod("init");
-    if (initializer)
-        return initializer->Arity();
-    return 0;
+    return mInitializer.IsNil() ? 0 : mInitializer.AsFunction().Arity();
 }
 
-shared_ptr<LoxFunction> LoxClass::FindMethod(const string &name) const
+LoxFunction *LoxClass::FindMethod(const HashedString &name) const
 {
-    if (mMethods.contains(name))
-        return mMethods.at(name);
+    auto method = FindMethodValue(name);
+    return method ? &method->AsFunction() : nullptr;
+}
+
+const Value *LoxClass::FindMethodValue(const HashedString &name) const
+{
+    auto found = mMethods.find(name);
+    return found != mMethods.end() ? &found->second : nullptr;
+}
+
+void LoxClass::Inherit(LoxClass *superclass)
+{
+    mSuperclass = superclass;
+    // the table of superclass is already flattened, so one level of copying covers the whole hierarchy
+    for (auto &[name, method] : superclass->mMethods)
+        mMethods.emplace(name, method);
+    CacheInitializer();
+}
 
-    return mSuperclass ? mSuperclass->FindMethod(name) : nullptr;
+void LoxClass::ResolveSuperMethods(const vector<Token *> &names)
+{
+    mSuperMethods.clear();
+    for (auto name : names)
+    {
+        auto method = mSuperclass->FindMethodValue(name->Name());
+        mSuperMethods.push_back(method ? *method : Value());
+    }
+}
+
+void LoxClass::CacheInitializer()
+{
+    auto initializer = FindMethodValue("init");
+    mInitializer = initializer ? *initializer : Value();
 }
 
 /* LoxInstance */
-shared_ptr<Value> LoxInstance::Get(const Token &name)
+Value LoxInstance::Get(Heap &heap, const Token &name, PropertySite &site)
+{
+    auto property = Resolve(name, site);
+    if (property.mSlot >= 0)
+        return SlotAt(property.mSlot);
+    return property.mMethod->AsFunction().Bind(heap, this);
+}
+
+PropertyCacheEntry LoxInstance::Resolve(const Token &name, PropertySite &site) const
 {
-    if (mFields.contains(name.Lexeme()))
-        return mFields.at(name.Lexeme());
+    auto cached = site.Find(mShape);
+    if (cached)
+        return *cached;
 
-    auto method = mKlass.FindMethod(name.Lexeme());
+    auto slot = mShape->Lookup(name.Name());
+    if (slot >= 0)
+    {
+        PropertyCacheEntry entry{mShape->Id(), slot, nullptr, nullptr};
+        site.Add(entry);
+        return entry;
+    }
+
+    auto method = mKlass->FindMethodValue(name.Name());
     if (method)
-        return method->Bind(shared_from_this());
+    {
+        PropertyCacheEntry entry{mShape->Id(), -1, method, nullptr};
+        site.Add(entry);
+        return entry;
+    }
 
     throw RuntimeError(name, "Undefined property '" + name.Lexeme() + "'.");
 }
 
-void LoxInstance::Set(const Token &name, const shared_ptr<Value> &value)
+void LoxInstance::Set(const Token &name, const Value &value, PropertySite &site)
+{
+    auto cached = site.Find(mShape);
+    if (cached)
+    {
+        if (cached->mTransition)
+            AddSlot(cached->mTransition, value);
+        else
+            SlotAt(cached->mSlot) = value;
+        return;
+    }
+
+    auto shapeId = mShape->Id();
+    auto slot = mShape->Lookup(name.Name());
+    if (slot >= 0)
+    {
+        site.Add(PropertyCacheEntry{shapeId, slot, nullptr, nullptr});
+        SlotAt(slot) = value;
+        return;
+    }
+
+    slot = mShape->SlotCount();
+    auto transition = mShape->Transition(name.Name());
+    site.Add(PropertyCacheEntry{shapeId, slot, nullptr, transition});
+    AddSlot(transition, value);
+}
+
+bool LoxInstance::GetField(const HashedString &name, Value &value) const
+{
+    auto slot = mShape->Lookup(name);
+    if (slot < 0)
+        return false;
+
+    value = SlotAt(slot);
+    return true;
+}
+
+void LoxInstance::SetField(const HashedString &name, const Value &value)
+{
+    auto slot = mShape->Lookup(name);
+    if (slot < 0)
+    {
+        AddSlot(mShape->Transition(name), value);
+        return;
+    }
+    SlotAt(slot) = value;
+}
+
+void LoxInstance::AddSlot(Shape *shape, const Value &value)
 {
-    mFields[name.Lexeme()] = value;
+    auto slot = mShape->SlotCount();
+    mShape = shape;
+    if (slot >= INLINE_SLOTS)
+        mOverflow.emplace_back();
+    SlotAt(slot) = value;
 }
 
 } // namespace lox
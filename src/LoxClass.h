@@ -1,47 +1,78 @@
 #pragma once
 
-#include "Environment.h"
+#include "Heap.h"
 #include "LoxCallable.h"
 #include "LoxFunction.h"
-#include <unordered_map>
+#include "Shape.h"
+#include "StringHash.h"
+#include <vector>
 
 namespace lox
 {
 
 class LoxInstance;
 
-using std::enable_shared_from_this;
 using std::string;
-using std::unordered_map;
 
+// A class with its inherited methods flattened into its own method table, so finding a method is one lookup
+// whatever the depth of the hierarchy.
 class LoxClass : public LoxCallable
 {
     friend class LoxInstance;
 
   public:
-    LoxClass(const string &name, LoxClass *superclass, unordered_map<string, shared_ptr<LoxFunction>> &&methods)
-        : mName(name), mSuperclass(superclass), mMethods(std::move(methods))
+    LoxClass(const string &name, LoxClass *superclass, StringMap<Value> &&methods)
+        : LoxCallable(OBJ_KIND_CLASS), mName(name), mSuperclass(nullptr), mMethods(std::move(methods))
     {
+        if (superclass)
+            Inherit(superclass);
+        CacheInitializer();
     }
 
     size_t Arity() const;
-    shared_ptr<Value> Call(Interpreter &interpreter, const vector<shared_ptr<Value>> &arguments);
+    Value Call(Interpreter &interpreter, Arguments arguments);
 
-    shared_ptr<LoxFunction> FindMethod(const string &name) const;
+    LoxFunction *FindMethod(const HashedString &name) const;
+    // engine neutral lookup, the bytecode VM stores closures as methods
+    const Value *FindMethodValue(const HashedString &name) const;
 
-    /* Value */
-    LoxClass &AsClass() override
+    // the method of the superclass that the super expression with target refers to, nil when there is none
+    const Value &SuperMethod(int target) const
     {
-        return *this;
+        return mSuperMethods[target];
     }
-    virtual const bool IsClass() const override
+    // looks up the methods of the superclass named by the super expressions within the class, in target order.
+    // The superclass never changes, so that is done once when the class is created.
+    void ResolveSuperMethods(const vector<Token *> &names);
+
+    // the "init" method, nullptr when the class and its superclasses have none
+    const Value *Initializer() const
+    {
+        return mInitializer.IsNil() ? nullptr : &mInitializer;
+    }
+
+    /* incremental construction used by the bytecode VM */
+    // copies down the methods of superclass which the class does not define itself
+    void Inherit(LoxClass *superclass);
+    void AddMethod(const string &name, const Value &method)
     {
-        return true;
+        mMethods[name] = method;
+        CacheInitializer();
     }
 
-    virtual const bool Equals(const Value &other) const override
+    // shape of a freshly created instance
+    Shape *RootShape()
     {
-        throw std::runtime_error("[ERROR on LoxClass#Equals] not implemented."); // TODO
+        return &mRootShape;
+    }
+
+    virtual void Trace(Heap &heap) const override
+    {
+        heap.Mark(mSuperclass);
+        for (auto &[name, method] : mMethods)
+            heap.Mark(method);
+        for (auto &method : mSuperMethods)
+            heap.Mark(method);
     }
 
     virtual const string Str() const override
@@ -50,45 +81,76 @@ class LoxClass : public LoxCallable
     }
 
   private:
+    void CacheInitializer();
+
     string mName;
     LoxClass *mSuperclass;
-    unordered_map<string, shared_ptr<LoxFunction>> mMethods;
+    // methods of the class and every superclass, the closest definition wins.
+    // Methods cannot be added once a class is declared, so the table is complete after the declaration.
+    StringMap<Value> mMethods;
+    Value mInitializer;
+    vector<Value> mSuperMethods;
+    Shape mRootShape;
 };
 
-class LoxInstance : public Value, public enable_shared_from_this<LoxInstance>
+// Field values live in slots laid out by the instance's shape.
+// The first INLINE_SLOTS of them are stored in the object itself, the rest spill into mOverflow.
+class LoxInstance : public Obj
 {
   public:
-    LoxInstance(const LoxClass &klass) : mKlass(klass)
+    static constexpr int INLINE_SLOTS = 4;
+
+    LoxInstance(LoxClass *klass) : Obj(OBJ_KIND_INSTANCE), mKlass(klass), mShape(klass->RootShape())
     {
     }
 
-    shared_ptr<Value> Get(const Token &name);
-    void Set(const Token &name, const shared_ptr<Value> &value);
+    // property access through the inline cache of the accessing site
+    Value Get(Heap &heap, const Token &name, PropertySite &site);
+    // the field slot or the method a name refers to, without binding the method
+    PropertyCacheEntry Resolve(const Token &name, PropertySite &site) const;
+    void Set(const Token &name, const Value &value, PropertySite &site);
+
+    bool GetField(const HashedString &name, Value &value) const;
+    void SetField(const HashedString &name, const Value &value);
 
-    /* Value */
-    LoxInstance &AsInstance() override
+    LoxClass &Klass() const
+    {
+        return *mKlass;
+    }
+    const Shape *GetShape() const
     {
-        return *this;
+        return mShape;
     }
 
-    virtual const bool IsInstance() const override
+    const Value &SlotAt(int slot) const
     {
-        return true;
+        return slot < INLINE_SLOTS ? mInline[slot] : mOverflow[slot - INLINE_SLOTS];
+    }
+    Value &SlotAt(int slot)
+    {
+        return slot < INLINE_SLOTS ? mInline[slot] : mOverflow[slot - INLINE_SLOTS];
     }
 
-    virtual const bool Equals(const Value &other) const override
+    virtual void Trace(Heap &heap) const override
     {
-        throw std::runtime_error("[ERROR on LoxInstance#Equals] not implemented."); // TODO
+        heap.Mark(mKlass);
+        for (int i = 0; i < mShape->SlotCount(); i++)
+            heap.Mark(SlotAt(i));
     }
 
     virtual const string Str() const override
     {
-        return mKlass.mName + " instance";
+        return mKlass->mName + " instance";
     }
 
   private:
-    const LoxClass &mKlass;
-    unordered_map<string, shared_ptr<Value>> mFields;
+    // stores the value of the field that the transition to shape adds
+    void AddSlot(Shape *shape, const Value &value);
+
+    LoxClass *mKlass;
+    Shape *mShape;
+    Value mInline[INLINE_SLOTS];
+    vector<Value> mOverflow;
 };
 
 } // namespace lox
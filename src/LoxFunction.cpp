@@ -6,36 +6,39 @@
 namespace lox
 {
 
-shared_ptr<Value> LoxFunction::Call(Interpreter &interpreter, const vector<shared_ptr<Value>> &arguments)
+Value LoxFunction::Call(Interpreter &interpreter, Arguments arguments)
 {
-    auto environment = make_shared<Environment>(mClosure);
-
-    // define function arguments as local variables
-    for (size_t i = 0; i < mDeclaration.mParams.size(); i++)
-        environment->Define(mDeclaration.mParams.at(i)->Lexeme(), arguments.at(i));
-
-    try
-    {
-        interpreter.ExecuteBlock(mDeclaration.mBody, environment);
-    }
-    catch (const FunctionReturn &returnValue)
-    {
-        return mIsInitializer ? mClosure->GetAt(0, "this") : returnValue.mValue;
-    }
-
-    return mIsInitializer ? mClosure->GetAt(0, "this") : nullptr;
+    return Invoke(interpreter, mReceiver, arguments);
+}
+
+Value LoxFunction::Invoke(Interpreter &interpreter, Value receiver, Arguments arguments)
+{
+    auto &frame = mDeclaration->mFrame;
+
+    // the receiver of a method and then the function arguments occupy the first slots of the frame
+    auto hasReceiver = mType != FUNCTION_FUNCTION;
+    auto caller = interpreter.EnterFrame(this, arguments, hasReceiver, frame.mSize);
+    if (hasReceiver)
+        interpreter.Local(0) = receiver;
+    for (auto cell : frame.mCells)
+        interpreter.Local(cell) = Value(interpreter.mHeap.New<LoxCell>(interpreter.Local(cell)));
+
+    auto completion = interpreter.ExecuteBlock(mDeclaration->mBody);
+    interpreter.LeaveFrame(caller);
+
+    // the value is nil when the body completed without a return statement
+    return mType == FUNCTION_INITIALIZER ? receiver : completion.mValue;
 }
 
 size_t LoxFunction::Arity() const
 {
-    return mDeclaration.mParams.size();
+    return mDeclaration->mParams.size();
 }
 
-shared_ptr<LoxFunction> LoxFunction::Bind(const shared_ptr<LoxInstance> &instance)
+Value LoxFunction::Bind(Heap &heap, LoxInstance *instance)
 {
-    auto environment = make_shared<Environment>(mClosure);
-    environment->Define("this", instance);
-    return make_shared<LoxFunction>(mDeclaration, environment, mIsInitializer);
+    auto upvalues = mUpvalues;
+    return Value(heap.New<LoxFunction>(mDeclaration, std::move(upvalues), mType, Value(instance)));
 }
 
 } // namespace lox
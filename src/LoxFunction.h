@@ -1,56 +1,60 @@
 #pragma once
 
-#include "Environment.h"
 #include "LoxCallable.h"
+#include "LoxCell.h"
+#include "Resolver.h"
 
 namespace lox
 {
 
-struct FunctionReturn : public exception
-{
-    FunctionReturn(const shared_ptr<Value> value) : mValue(value)
-    {
-    }
-    const shared_ptr<Value> mValue;
-};
-
+// A closure over a function declaration.
+// The declaration is the prototype every closure of it shares: the tree outlives the functions that point into it and
+// is never changed after the Resolver annotated it, so creating or binding a closure copies nothing of it.
+// A closure keeps the cells of the variables it captures, never the frames they were declared in.
 class LoxFunction : public LoxCallable
 {
   public:
-    LoxFunction(const Function &declaration, const shared_ptr<Environment> &closure, const bool isInitializer)
-        : mDeclaration(declaration), mClosure(closure), mIsInitializer(isInitializer)
+    LoxFunction(const Function *declaration, vector<LoxCell *> &&upvalues, FunctionType type)
+        : LoxFunction(declaration, std::move(upvalues), type, Value())
+    {
+    }
+    LoxFunction(const Function *declaration, vector<LoxCell *> &&upvalues, FunctionType type, const Value &receiver)
+        : LoxCallable(OBJ_KIND_FUNCTION), mDeclaration(declaration), mUpvalues(std::move(upvalues)), mType(type),
+          mReceiver(receiver)
     {
     }
 
     size_t Arity() const;
-    shared_ptr<Value> Call(Interpreter &interpreter, const vector<shared_ptr<Value>> &arguments);
+    Value Call(Interpreter &interpreter, Arguments arguments);
+    // calls a method with the receiver passed straight into its frame, without binding it first
+    Value Invoke(Interpreter &interpreter, Value receiver, Arguments arguments);
 
-    shared_ptr<LoxFunction> Bind(const shared_ptr<LoxInstance> &instance);
+    // only needed when a method is used as a value
+    Value Bind(Heap &heap, LoxInstance *instance);
 
-    /* Value */
-    LoxFunction &AsFunction() override
-    {
-        return *this;
-    }
-    virtual const bool IsFunction() const override
+    LoxCell *Upvalue(int index) const
     {
-        return true;
+        return mUpvalues[index];
     }
 
-    virtual const bool Equals(const Value &other) const override
+    virtual void Trace(Heap &heap) const override
     {
-        throw std::runtime_error("[ERROR on FunctionValue#Equals] not implemented."); // TODO
+        for (auto upvalue : mUpvalues)
+            heap.Mark(upvalue);
+        heap.Mark(mReceiver);
     }
 
     virtual const string Str() const override
     {
-        return "<fn " + mDeclaration.mName->Lexeme() + ">";
+        return "<fn " + mDeclaration->mName->Lexeme() + ">";
     }
 
   private:
-    Function mDeclaration; // TODO
-    shared_ptr<Environment> mClosure;
-    const bool mIsInitializer;
+    const Function *mDeclaration;
+    vector<LoxCell *> mUpvalues;
+    const FunctionType mType;
+    // the instance a method was bound to
+    Value mReceiver;
 };
 
 } // namespace lox
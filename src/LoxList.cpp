@@ -0,0 +1,39 @@
+#include "LoxList.h"
+
+#include <cmath>
+
+namespace lox
+{
+
+const char *LoxList::CheckIndex(const Value &index, size_t &position) const
+{
+    if (!index.IsNumber())
+        return "List index must be a number.";
+
+    auto number = index.AsNumber();
+    if (number != std::floor(number) || number < 0 || number >= mElements.size())
+        return "List index out of range.";
+
+    position = static_cast<size_t>(number);
+    return nullptr;
+}
+
+const string LoxList::Str() const
+{
+    // a list that contains itself, directly or through other containers, is not expanded again
+    if (mPrinting)
+        return "[...]";
+
+    mPrinting = true;
+    string str = "[";
+    for (size_t i = 0; i < mElements.size(); i++)
+    {
+        if (i != 0)
+            str += ", ";
+        str += mElements[i].Str();
+    }
+    mPrinting = false;
+    return str + "]";
+}
+
+} // namespace lox
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Heap.h"
+#include "Value.h"
+
+#include <string>
+#include <vector>
+
+namespace lox
+{
+
+using std::string;
+using std::vector;
+
+// Growable array of values stored contiguously. Indexing with a number is a bounds check and a load.
+class LoxList : public Obj
+{
+  public:
+    LoxList() : Obj(OBJ_KIND_LIST)
+    {
+    }
+    LoxList(vector<Value> &&elements) : Obj(OBJ_KIND_LIST), mElements(std::move(elements))
+    {
+    }
+    LoxList(const Value *elements, size_t count) : Obj(OBJ_KIND_LIST), mElements(elements, elements + count)
+    {
+    }
+
+    size_t Size() const
+    {
+        return mElements.size();
+    }
+    const Value &At(size_t position) const
+    {
+        return mElements[position];
+    }
+    Value &At(size_t position)
+    {
+        return mElements[position];
+    }
+    void Push(Heap &heap, const Value &value)
+    {
+        auto capacity = mElements.capacity();
+        mElements.push_back(value);
+        if (mElements.capacity() != capacity)
+            heap.Resize(this);
+    }
+    Value Pop()
+    {
+        auto value = mElements.back();
+        mElements.pop_back();
+        return value;
+    }
+    const vector<Value> &Elements() const
+    {
+        return mElements;
+    }
+
+    // nullptr if index names an element, otherwise the error to report. position receives the element index.
+    const char *CheckIndex(const Value &index, size_t &position) const;
+
+    size_t StorageBytes() const
+    {
+        return mElements.capacity() * sizeof(Value);
+    }
+
+    virtual void Trace(Heap &heap) const override
+    {
+        for (auto &element : mElements)
+            heap.Mark(element);
+    }
+
+    virtual const string Str() const override;
+
+  private:
+    vector<Value> mElements;
+};
+
+} // namespace lox
@@ -0,0 +1,189 @@
+#include "LoxMap.h"
+
+#include <cmath>
+
+namespace lox
+{
+
+const char *LoxMap::CheckKey(const Value &key)
+{
+    if (key.IsString() || key.IsBoolean())
+        return nullptr;
+    // NaN never equals itself, so it could be inserted but never found
+    if (key.IsNumber() && !std::isnan(key.AsNumber()))
+        return nullptr;
+    return "Map key must be a number, string or boolean.";
+}
+
+uint32_t LoxMap::Hash(const Value &key)
+{
+    // strings are interned with their hash
+    if (key.IsString())
+        return static_cast<LoxString *>(key.AsObj())->Hash();
+
+    uint64_t bits;
+    if (key.IsNumber())
+    {
+        // -0 equals 0, so both must hash alike
+        double number = key.AsNumber() == 0 ? 0.0 : key.AsNumber();
+        std::memcpy(&bits, &number, sizeof(double));
+    }
+    else
+        bits = key.AsBoolean() ? 1 : 2;
+
+    bits ^= bits >> 33;
+    bits *= 0xff51afd7ed558ccdULL;
+    bits ^= bits >> 33;
+    return static_cast<uint32_t>(bits);
+}
+
+LoxMap::Entry *LoxMap::FindEntry(const Value &key, uint32_t hash) const
+{
+    auto entries = const_cast<Entry *>(mEntries.data());
+    size_t mask = mEntries.size() - 1;
+    Entry *tombstone = nullptr;
+
+    for (size_t index = hash & mask;; index = (index + 1) & mask)
+    {
+        auto entry = &entries[index];
+        if (entry->mKey.IsNil())
+        {
+            if (entry->mValue.IsNil())
+                return tombstone ? tombstone : entry;
+            if (!tombstone)
+                tombstone = entry;
+        }
+        else if (entry->mHash == hash && entry->mKey.Equals(key))
+            return entry;
+    }
+}
+
+void LoxMap::Rehash(Heap &heap)
+{
+    // size the table for the live entries alone, so tombstones are dropped instead of doubling the table, and leave
+    // it at most half full so the next rehash is as many inserts away as this one cost
+    size_t capacity = 8;
+    while ((mSize + 1) * 2 > capacity)
+        capacity *= 2;
+
+    vector<Entry> entries(capacity);
+    std::swap(entries, mEntries);
+
+    mUsed = mSize;
+    size_t mask = mEntries.size() - 1;
+    for (auto &entry : entries)
+    {
+        if (entry.mKey.IsNil())
+            continue;
+
+        // cached hashes let the keys move without being hashed again
+        auto index = entry.mHash & mask;
+        while (!mEntries[index].mKey.IsNil())
+            index = (index + 1) & mask;
+        mEntries[index] = entry;
+    }
+    heap.Resize(this);
+}
+
+bool LoxMap::Get(const Value &key, Value &value) const
+{
+    if (mSize == 0)
+        return false;
+
+    auto entry = FindEntry(key, Hash(key));
+    if (entry->mKey.IsNil())
+        return false;
+    value = entry->mValue;
+    return true;
+}
+
+bool LoxMap::Set(Heap &heap, const Value &key, const Value &value)
+{
+    if (mEntries.empty())
+        Rehash(heap);
+
+    auto hash = Hash(key);
+    auto entry = FindEntry(key, hash);
+    bool isNew = entry->mKey.IsNil();
+    if (isNew)
+    {
+        // reusing a tombstone does not lengthen any probe sequence, filling an empty entry must keep the table at
+        // most 3/4 full
+        if (entry->mValue.IsNil() && (mUsed + 1) * 4 > mEntries.size() * 3)
+        {
+            Rehash(heap);
+            entry = FindEntry(key, hash);
+        }
+        mSize++;
+        if (entry->mValue.IsNil())
+            mUsed++;
+    }
+
+    entry->mKey = key;
+    entry->mValue = value;
+    entry->mHash = hash;
+    return isNew;
+}
+
+bool LoxMap::Delete(const Value &key)
+{
+    if (mSize == 0)
+        return false;
+
+    auto entry = FindEntry(key, Hash(key));
+    if (entry->mKey.IsNil())
+        return false;
+
+    entry->mKey = Value();
+    entry->mValue = Value(true);
+    mSize--;
+    return true;
+}
+
+vector<Value> LoxMap::Keys() const
+{
+    vector<Value> keys;
+    keys.reserve(mSize);
+    for (auto &entry : mEntries)
+    {
+        if (!entry.mKey.IsNil())
+            keys.push_back(entry.mKey);
+    }
+    return keys;
+}
+
+void LoxMap::Trace(Heap &heap) const
+{
+    for (auto &entry : mEntries)
+    {
+        if (!entry.mKey.IsNil())
+        {
+            heap.Mark(entry.mKey);
+            heap.Mark(entry.mValue);
+        }
+    }
+}
+
+const string LoxMap::Str() const
+{
+    // a map that contains itself, directly or through other containers, is not expanded again
+    if (mPrinting)
+        return "{...}";
+
+    mPrinting = true;
+    string str = "{";
+    bool first = true;
+    for (auto &entry : mEntries)
+    {
+        if (entry.mKey.IsNil())
+            continue;
+        if (!first)
+            str += ", ";
+        first = false;
+        str += entry.mKey.Str() + ": " + entry.mValue.Str();
+    }
+    mPrinting = false;
+    return str + "}";
+}
+
+} // namespace lox
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Heap.h"
+#include "Value.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lox
+{
+
+using std::string;
+using std::vector;
+
+// Hash table keyed by numbers, strings and booleans.
+// Entries live in one array probed linearly, each caching the hash of its key so that probing and growing compare
+// and rehash nothing but the keys that actually collide. Interned strings bring their hash along and compare by
+// identity, so a string key costs no more than a number. Deleted entries leave a tombstone behind to keep probe
+// sequences intact.
+class LoxMap : public Obj
+{
+  public:
+    LoxMap() : Obj(OBJ_KIND_MAP)
+    {
+    }
+
+    // nullptr if key can be used as a map key, otherwise the error to report
+    static const char *CheckKey(const Value &key);
+
+    size_t Size() const
+    {
+        return mSize;
+    }
+
+    // the following expect a key that passed CheckKey
+    bool Get(const Value &key, Value &value) const;
+    // true if key was not in the map before
+    bool Set(Heap &heap, const Value &key, const Value &value);
+    // true if key was in the map
+    bool Delete(const Value &key);
+
+    vector<Value> Keys() const;
+
+    size_t StorageBytes() const
+    {
+        return mEntries.capacity() * sizeof(Entry);
+    }
+
+    virtual void Trace(Heap &heap) const override;
+
+    virtual const string Str() const override;
+
+  private:
+    // an empty entry has a nil key and a nil value, a tombstone has a nil key and a true value
+    struct Entry
+    {
+        Value mKey;
+        Value mValue;
+        uint32_t mHash = 0;
+    };
+
+    static uint32_t Hash(const Value &key);
+    Entry *FindEntry(const Value &key, uint32_t hash) const;
+    void Rehash(Heap &heap);
+
+    vector<Entry> mEntries;
+    // live entries
+    size_t mSize = 0;
+    // live entries and tombstones, which both lengthen probe sequences
+    size_t mUsed = 0;
+};
+
+} // namespace lox
@@ -0,0 +1,260 @@
+#include "LoxNative.h"
+#include "Interpreter.h"
+#include "LoxList.h"
+#include "LoxMap.h"
+#include "LoxRope.h"
+
+#include <chrono>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+
+namespace lox
+{
+
+Value LoxNative::Call(Interpreter &interpreter, Arguments arguments)
+{
+    return Invoke(interpreter.GetHeap(), arguments.data());
+}
+
+static double NumberArg(const Value &value, const char *native)
+{
+    if (!value.IsNumber())
+        throw NativeError(string(native) + "() expects a number.");
+    return value.AsNumber();
+}
+
+static const string &StringArg(Heap &heap, const Value &value, const char *native)
+{
+    if (value.IsRope())
+        return value.AsRope().Flatten(heap)->AsString();
+    if (!value.IsString())
+        throw NativeError(string(native) + "() expects a string.");
+    return value.AsString();
+}
+
+static LoxList &ListArg(const Value &value, const char *native)
+{
+    if (!value.IsList())
+        throw NativeError(string(native) + "() expects a list.");
+    return value.AsList();
+}
+
+static LoxMap &MapArg(const Value &value, const char *native)
+{
+    if (!value.IsMap())
+        throw NativeError(string(native) + "() expects a map.");
+    return value.AsMap();
+}
+
+static Value KeyArg(Heap &heap, const Value &value)
+{
+    auto key = LoxRope::Flatten(heap, value);
+    if (auto error = LoxMap::CheckKey(key))
+        throw NativeError(error);
+    return key;
+}
+
+// an integral number in [0, limit]
+static size_t IndexArg(const Value &value, size_t limit, const char *native)
+{
+    auto index = NumberArg(value, native);
+    if (index != std::floor(index) || index < 0 || index > limit)
+        throw NativeError(string(native) + "() index out of range.");
+    return static_cast<size_t>(index);
+}
+
+static Value Clock(Heap &heap, const Value *args)
+{
+    std::chrono::duration<double> now = std::chrono::steady_clock::now().time_since_epoch();
+    return Value(now.count());
+}
+
+/* math */
+
+static Value Abs(Heap &heap, const Value *args)
+{
+    return Value(std::fabs(NumberArg(args[0], "abs")));
+}
+
+static Value Floor(Heap &heap, const Value *args)
+{
+    return Value(std::floor(NumberArg(args[0], "floor")));
+}
+
+static Value Sqrt(Heap &heap, const Value *args)
+{
+    return Value(std::sqrt(NumberArg(args[0], "sqrt")));
+}
+
+static Value Pow(Heap &heap, const Value *args)
+{
+    return Value(std::pow(NumberArg(args[0], "pow"), NumberArg(args[1], "pow")));
+}
+
+static Value Min(Heap &heap, const Value *args)
+{
+    return Value(std::fmin(NumberArg(args[0], "min"), NumberArg(args[1], "min")));
+}
+
+static Value Max(Heap &heap, const Value *args)
+{
+    return Value(std::fmax(NumberArg(args[0], "max"), NumberArg(args[1], "max")));
+}
+
+/* strings and collections */
+
+static Value Len(Heap &heap, const Value *args)
+{
+    if (args[0].IsList())
+        return Value(static_cast<double>(args[0].AsList().Size()));
+    if (args[0].IsMap())
+        return Value(static_cast<double>(args[0].AsMap().Size()));
+    if (args[0].IsRope())
+        return Value(static_cast<double>(args[0].AsRope().Length()));
+    if (!args[0].IsString())
+        throw NativeError("len() expects a string, a list or a map.");
+    return Value(static_cast<double>(args[0].AsString().size()));
+}
+
+// substring(s, start, end) is the part of s in [start, end)
+static Value Substring(Heap &heap, const Value *args)
+{
+    auto &str = StringArg(heap, args[0], "substring");
+    auto start = IndexArg(args[1], str.size(), "substring");
+    auto end = IndexArg(args[2], str.size(), "substring");
+    if (start > end)
+        throw NativeError("substring() start is after end.");
+    return Value(heap.Intern(str.substr(start, end - start)));
+}
+
+static Value CharCode(Heap &heap, const Value *args)
+{
+    auto &str = StringArg(heap, args[0], "charCode");
+    if (str.empty())
+        throw NativeError("charCode() index out of range.");
+    auto index = IndexArg(args[1], str.size() - 1, "charCode");
+    return Value(static_cast<double>(static_cast<unsigned char>(str[index])));
+}
+
+// push(list, value) appends value and returns the new length
+static Value Push(Heap &heap, const Value *args)
+{
+    auto &list = ListArg(args[0], "push");
+    list.Push(heap, args[1]);
+    return Value(static_cast<double>(list.Size()));
+}
+
+static Value Pop(Heap &heap, const Value *args)
+{
+    auto &list = ListArg(args[0], "pop");
+    if (list.Size() == 0)
+        throw NativeError("pop() from an empty list.");
+    return list.Pop();
+}
+
+// slice(list, start, end) is a new list of the elements in [start, end)
+static Value Slice(Heap &heap, const Value *args)
+{
+    auto &list = ListArg(args[0], "slice");
+    auto start = IndexArg(args[1], list.Size(), "slice");
+    auto end = IndexArg(args[2], list.Size(), "slice");
+    if (start > end)
+        throw NativeError("slice() start is after end.");
+    return Value(heap.New<LoxList>(list.Elements().data() + start, end - start));
+}
+
+// get(map, key) is the value stored under key, or nil
+static Value Get(Heap &heap, const Value *args)
+{
+    auto &map = MapArg(args[0], "get");
+    Value value;
+    map.Get(KeyArg(heap, args[1]), value);
+    return value;
+}
+
+// set(map, key, value) stores value under key and returns it
+static Value Set(Heap &heap, const Value *args)
+{
+    MapArg(args[0], "set").Set(heap, KeyArg(heap, args[1]), args[2]);
+    return args[2];
+}
+
+static Value Has(Heap &heap, const Value *args)
+{
+    auto &map = MapArg(args[0], "has");
+    Value value;
+    return Value(map.Get(KeyArg(heap, args[1]), value));
+}
+
+// delete(map, key) removes key and returns whether it was there
+static Value Delete(Heap &heap, const Value *args)
+{
+    return Value(MapArg(args[0], "delete").Delete(KeyArg(heap, args[1])));
+}
+
+// keys(map) is a new list of the keys of map, in no particular order
+static Value Keys(Heap &heap, const Value *args)
+{
+    return Value(heap.New<LoxList>(MapArg(args[0], "keys").Keys()));
+}
+
+// true if str is a number literal as the scanner reads it, with an optional leading minus
+static bool IsNumberLiteral(const string &str)
+{
+    auto isDigit = [](char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; };
+
+    size_t i = str.size() > 0 && str[0] == '-';
+    size_t start = i;
+    while (i < str.size() && isDigit(str[i]))
+        i++;
+    if (i == start)
+        return false;
+    if (i < str.size() && str[i] == '.')
+    {
+        start = ++i;
+        while (i < str.size() && isDigit(str[i]))
+            i++;
+        if (i == start)
+            return false;
+    }
+    return i == str.size();
+}
+
+// the number the whole string spells, or nil
+static Value ParseNumber(Heap &heap, const Value *args)
+{
+    auto &str = StringArg(heap, args[0], "parseNumber");
+    // strtod reads more than Lox spells, such as whitespace, hexadecimal, exponents, nan and inf
+    if (!IsNumberLiteral(str))
+        return Value();
+    return Value(std::strtod(str.c_str(), nullptr));
+}
+
+const vector<NativeDef> &Natives()
+{
+    static const vector<NativeDef> natives = {
+        {"clock", 0, Clock},
+        {"abs", 1, Abs},
+        {"floor", 1, Floor},
+        {"sqrt", 1, Sqrt},
+        {"pow", 2, Pow},
+        {"min", 2, Min},
+        {"max", 2, Max},
+        {"len", 1, Len},
+        {"substring", 3, Substring},
+        {"charCode", 2, CharCode},
+        {"parseNumber", 1, ParseNumber},
+        {"push", 2, Push},
+        {"pop", 1, Pop},
+        {"slice", 3, Slice},
+        {"get", 2, Get},
+        {"set", 3, Set},
+        {"has", 2, Has},
+        {"delete", 2, Delete},
+        {"keys", 1, Keys},
+    };
+    return natives;
+}
+
+} // namespace lox
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Heap.h"
+#include "LoxCallable.h"
+
+#include <string>
+
+namespace lox
+{
+
+using std::string;
+
+// Thrown by a native on bad arguments. Each engine reports it as a runtime error at the call site.
+class NativeError : public exception
+{
+  public:
+    NativeError(const string &msg) : mMsg(msg)
+    {
+    }
+    virtual const char *what() const throw()
+    {
+        return mMsg.c_str();
+    }
+    const string mMsg;
+};
+
+// Natives read their arguments through a pointer into storage owned by the caller (the stack of either engine), so a
+// call does not build an argument vector. The caller has checked the arity.
+// Natives may allocate from heap but never trigger a collection.
+using NativeFn = Value (*)(Heap &heap, const Value *args);
+
+class LoxNative : public LoxCallable
+{
+  public:
+    LoxNative(const string &name, size_t arity, NativeFn function)
+        : LoxCallable(OBJ_KIND_NATIVE), mName(name), mArity(arity), mFunction(function)
+    {
+    }
+
+    virtual size_t Arity() const override
+    {
+        return mArity;
+    }
+    virtual Value Call(Interpreter &interpreter, Arguments arguments) override;
+
+    Value Invoke(Heap &heap, const Value *args) const
+    {
+        return mFunction(heap, args);
+    }
+
+    virtual const string Str() const override
+    {
+        return "<native fn " + mName + ">";
+    }
+
+  private:
+    const string mName;
+    const size_t mArity;
+    const NativeFn mFunction;
+};
+
+struct NativeDef
+{
+    const char *mName;
+    size_t mArity;
+    NativeFn mFunction;
+};
+
+// the built-in functions every engine installs as globals
+const vector<NativeDef> &Natives();
+
+} // namespace lox
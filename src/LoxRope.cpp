@@ -0,0 +1,58 @@
+#include "LoxRope.h"
+
+#include <vector>
+
+namespace lox
+{
+
+void LoxRope::AppendTo(string &str) const
+{
+    // ropes built in a loop are as deep as the loop ran, so walk them with an explicit stack, left part on top
+    std::vector<Value> pending{mRight, mLeft};
+    while (!pending.empty())
+    {
+        auto part = pending.back();
+        pending.pop_back();
+        if (!part.IsRope())
+        {
+            str += part.AsString();
+            continue;
+        }
+
+        auto &rope = part.AsRope();
+        if (rope.mFlat)
+            str += rope.mFlat->AsString();
+        else
+        {
+            pending.push_back(rope.mRight);
+            pending.push_back(rope.mLeft);
+        }
+    }
+}
+
+LoxString *LoxRope::Flatten(Heap &heap)
+{
+    if (!mFlat)
+    {
+        string str;
+        str.reserve(mLength);
+        AppendTo(str);
+        mFlat = heap.Intern(std::move(str));
+        mLeft = Value();
+        mRight = Value();
+    }
+    return mFlat;
+}
+
+const string LoxRope::Str() const
+{
+    if (mFlat)
+        return mFlat->AsString();
+
+    string str;
+    str.reserve(mLength);
+    AppendTo(str);
+    return str;
+}
+
+} // namespace lox
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Heap.h"
+#include "Value.h"
+
+#include <string>
+
+namespace lox
+{
+
+using std::string;
+
+// A string built by concatenation that has not been flattened yet.
+// s = s + piece in a loop allocates one small node per step instead of copying s every time. The characters are
+// only gathered, and interned, once something needs the string itself: comparing it, using it as a map key or
+// passing it to a native. A flattened rope forgets its parts and keeps the string.
+class LoxRope : public Obj
+{
+  public:
+    // concatenations shorter than this are interned right away, so ropes are never short
+    static constexpr size_t MIN_LENGTH = 64;
+
+    LoxRope(const Value &left, const Value &right)
+        : Obj(OBJ_KIND_ROPE), mLeft(left), mRight(right), mLength(Length(left) + Length(right))
+    {
+    }
+
+    size_t Length() const
+    {
+        return mLength;
+    }
+    LoxString *Flatten(Heap &heap);
+
+    // a string or a rope
+    static bool IsText(const Value &value)
+    {
+        return value.IsString() || value.IsRope();
+    }
+    static size_t Length(const Value &value)
+    {
+        return value.IsRope() ? value.AsRope().mLength : value.AsString().size();
+    }
+    // the flattened string of a rope, any other value unchanged
+    static Value Flatten(Heap &heap, const Value &value)
+    {
+        return value.IsRope() ? Value(value.AsRope().Flatten(heap)) : value;
+    }
+
+    virtual void Trace(Heap &heap) const override
+    {
+        heap.Mark(mFlat);
+        heap.Mark(mLeft);
+        heap.Mark(mRight);
+    }
+
+    virtual const string Str() const override;
+
+  private:
+    void AppendTo(string &str) const;
+
+    Value mLeft;
+    Value mRight;
+    size_t mLength;
+    LoxString *mFlat = nullptr;
+};
+
+} // namespace lox
@@ -3,15 +3,14 @@
 namespace lox
 {
 
-using std::shared_ptr;
 using std::vector;
 
 // Syntax Grammar
 // http://www.craftinginterpreters.com/appendix-i.html
 
-vector<shared_ptr<Stmt>> Parser::Parse()
+vector<Stmt *> Parser::Parse()
 {
-    vector<shared_ptr<Stmt>> stmts;
+    vector<Stmt *> stmts;
     while (!IsAtEnd())
         stmts.push_back(ParseDeclaration());
     return stmts;
@@ -21,7 +20,7 @@ vector<shared_ptr<Stmt>> Parser::Parse()
 //                | funDecl
 //                | varDecl
 //                | statement ;
-shared_ptr<Stmt> Parser::ParseDeclaration()
+Stmt *Parser::ParseDeclaration()
 {
     try
     {
@@ -42,35 +41,35 @@ shared_ptr<Stmt> Parser::ParseDeclaration()
 
 // classDecl      → "class" IDENTIFIER ( "<" IDENTIFIER )?
 //                  "{" function* "}" ;
-shared_ptr<Stmt> Parser::ParseClassDeclaration()
+Stmt *Parser::ParseClassDeclaration()
 {
     auto name = Consume(TOKEN_IDENTIFIER, "Expect class name.");
 
-    shared_ptr<Variable> superclass = nullptr;
+    Variable *superclass = nullptr;
     if (Match(TOKEN_LESS))
     {
         Consume(TOKEN_IDENTIFIER, "Expect superclass name.");
-        superclass = make_shared<Variable>(Previous());
+        superclass = mArena.New<Variable>(Previous());
     }
 
     Consume(TOKEN_LEFT_BRACE, "Expect '{' before class body.");
 
-    vector<shared_ptr<Function>> methods;
+    vector<Function *> methods;
     while (!Check(TOKEN_RIGHT_BRACE) && !IsAtEnd())
-        methods.push_back(static_pointer_cast<Function>(ParseFunction("method")));
+        methods.push_back(static_cast<Function *>(ParseFunction("method")));
 
     Consume(TOKEN_RIGHT_BRACE, "Expect '}' after class body.");
-    return make_shared<Class>(name, superclass, methods);
+    return mArena.New<Class>(name, superclass, methods);
 }
 
 // funDecl        → "fun" function ;
 // function       → IDENTIFIER "(" parameters? ")" block ;
-shared_ptr<Stmt> Parser::ParseFunction(const string &kind)
+Stmt *Parser::ParseFunction(const string &kind)
 {
     auto name = Consume(TOKEN_IDENTIFIER, "Expect " + kind + " name.");
 
     Consume(TOKEN_LEFT_PAREN, "Expect '(' after " + kind + " name.");
-    vector<shared_ptr<Token>> params;
+    vector<Token *> params;
     if (!Check(TOKEN_RIGHT_PAREN))
     {
         do
@@ -84,19 +83,19 @@ shared_ptr<Stmt> Parser::ParseFunction(const string &kind)
     Consume(TOKEN_RIGHT_PAREN, "Expect ')' after parameters.");
 
     Consume(TOKEN_LEFT_BRACE, "Expect '{' before " + kind + " body.");
-    auto body = static_pointer_cast<Block>(ParseBlock())->mStatements;
-    return make_shared<Function>(name, params, body);
+    auto body = static_cast<Block *>(ParseBlock())->mStatements;
+    return mArena.New<Function>(name, params, body);
 }
 
 // varDecl        → "var" IDENTIFIER ( "=" expression )? ";" ;
-shared_ptr<Stmt> Parser::ParseVarDeclaration()
+Stmt *Parser::ParseVarDeclaration()
 {
     auto name = Consume(TOKEN_IDENTIFIER, "Expect variable name.");
 
     auto initializer = Match(TOKEN_EQUAL) ? ParseExpression() : nullptr;
 
     Consume(TOKEN_SEMICOLON, "Expect ';' after declaration.");
-    return make_shared<Var>(name, initializer);
+    return mArena.New<Var>(name, initializer);
 }
 
 // statement      → exprStmt
@@ -106,7 +105,7 @@ shared_ptr<Stmt> Parser::ParseVarDeclaration()
 //                | returnStmt
 //                | whileStmt
 //                | block ;
-shared_ptr<Stmt> Parser::ParseStatement()
+Stmt *Parser::ParseStatement()
 {
     if (Match(TOKEN_FOR))
         return ParseForStatement();
@@ -126,12 +125,12 @@ shared_ptr<Stmt> Parser::ParseStatement()
 // forStmt        → "for" "(" ( varDecl | exprStmt | ";" )
 //                            expression? ";"
 //                            expression? ")" statement ;
-shared_ptr<Stmt> Parser::ParseForStatement()
+Stmt *Parser::ParseForStatement()
 {
     Consume(TOKEN_LEFT_PAREN, "Expect '(' after 'if'.");
 
     /* parse for syntax parts */
-    shared_ptr<Stmt> initializer;
+    Stmt *initializer;
     if (Match(TOKEN_SEMICOLON))
         initializer = nullptr;
     else if (Match(TOKEN_VAR))
@@ -149,21 +148,21 @@ shared_ptr<Stmt> Parser::ParseForStatement()
 
     /* construct to while node */
     if (iteration)
-        body = make_shared<Block>(vector<shared_ptr<Stmt>>{body, make_shared<Expression>(iteration)});
+        body = mArena.New<Block>(vector<Stmt *>{body, mArena.New<Expression>(iteration)});
 
     if (!condition)
-        condition = make_shared<Literal>(make_shared<Object>(OBJ_BOOL_TRUE));
-    body = make_shared<While>(condition, body);
+        condition = mArena.New<Literal>(mArena.New<Object>(OBJ_BOOL_TRUE));
+    body = mArena.New<While>(condition, body);
 
     if (initializer)
-        body = make_shared<Block>(vector<shared_ptr<Stmt>>{initializer, body});
+        body = mArena.New<Block>(vector<Stmt *>{initializer, body});
 
     return body;
 }
 
 // ifStmt         → "if" "(" expression ")" statement
 //                ( "else" statement )? ;
-shared_ptr<Stmt> Parser::ParseIfStatement()
+Stmt *Parser::ParseIfStatement()
 {
     Consume(TOKEN_LEFT_PAREN, "Expect '(' after 'if'.");
     auto condition = ParseExpression();
@@ -172,67 +171,68 @@ shared_ptr<Stmt> Parser::ParseIfStatement()
     auto thenBranch = ParseStatement();
     auto elseBranch = Match(TOKEN_ELSE) ? ParseStatement() : nullptr;
 
-    return make_shared<If>(condition, thenBranch, elseBranch);
+    return mArena.New<If>(condition, thenBranch, elseBranch);
 }
 
 // printStmt      → "print" expression ";" ;
-shared_ptr<Stmt> Parser::ParsePrintStatement()
+Stmt *Parser::ParsePrintStatement()
 {
-    shared_ptr<Expr> value = ParseExpression();
+    Expr *value = ParseExpression();
     Consume(TOKEN_SEMICOLON, "Expect ';' after value.");
-    return make_shared<Print>(value);
+    return mArena.New<Print>(value);
 }
 
 // returnStmt     → "return" expression? ";" ;
-shared_ptr<Stmt> Parser::ParseReturnStatement()
+Stmt *Parser::ParseReturnStatement()
 {
     auto keyword = Previous();
     auto value = Check(TOKEN_SEMICOLON) ? nullptr : ParseExpression();
 
     Consume(TOKEN_SEMICOLON, "Expect ';' after return value.");
-    return make_shared<Return>(keyword, value);
+    return mArena.New<Return>(keyword, value);
 }
 
 // whileStmt      → "while" "(" expression ")" statement ;
-shared_ptr<Stmt> Parser::ParseWhileStatement()
+Stmt *Parser::ParseWhileStatement()
 {
     Consume(TOKEN_LEFT_PAREN, "Expect '(' after 'while'.");
     auto condition = ParseExpression();
     Consume(TOKEN_RIGHT_PAREN, "Expect ')' after 'while'.");
     auto body = ParseStatement();
 
-    return make_shared<While>(condition, body);
+    return mArena.New<While>(condition, body);
 }
 
 // exprStmt       → expression ";" ;
-shared_ptr<Stmt> Parser::ParseExpressionStatement()
+Stmt *Parser::ParseExpressionStatement()
 {
-    shared_ptr<Expr> value = ParseExpression();
+    Expr *value = ParseExpression();
     Consume(TOKEN_SEMICOLON, "Expect ';' after value.");
-    return make_shared<Expression>(value);
+    return mArena.New<Expression>(value);
 }
 
 // block          → "{" declaration* "}" ;
-shared_ptr<Stmt> Parser::ParseBlock()
+Stmt *Parser::ParseBlock()
 {
-    vector<shared_ptr<Stmt>> stmts;
+    vector<Stmt *> stmts;
 
     while (!Check(TOKEN_RIGHT_BRACE) && !IsAtEnd())
         stmts.push_back(ParseDeclaration());
 
     Consume(TOKEN_RIGHT_BRACE, "Expect '}' after block.");
-    return make_shared<Block>(stmts);
+    return mArena.New<Block>(stmts);
 }
 
 // expression     → assignment ;
-shared_ptr<Expr> Parser::ParseExpression()
+Expr *Parser::ParseExpression()
 {
     return ParseAssignment();
 }
 
 // assignment     → ( call "." )? IDENTIFIER "=" assignment
+//                | call "[" expression "]" "=" assignment
 //                | logic_or ;
-shared_ptr<Expr> Parser::ParseAssignment()
+Expr *Parser::ParseAssignment()
 {
     auto expr = ParseOr(); // TODO change here
 
@@ -242,13 +242,18 @@ shared_ptr<Expr> Parser::ParseAssignment()
         auto value = ParseAssignment();
         if (typeid(*expr) == typeid(Variable))
         {
-            auto name = static_pointer_cast<Variable>(expr)->mName;
-            return make_shared<Assign>(name, value);
+            auto name = static_cast<Variable *>(expr)->mName;
+            return mArena.New<Assign>(name, value);
         }
         else if (typeid(*expr) == typeid(Get))
         {
-            auto get = static_pointer_cast<Get>(expr);
-            return make_shared<Set>(get->mObject, get->mName, value);
+            auto get = static_cast<Get *>(expr);
+            return mArena.New<Set>(get->mObject, get->mName, value);
+        }
+        else if (typeid(*expr) == typeid(Index))
+        {
+            auto index = static_cast<Index *>(expr);
+            return mArena.New<SetIndex>(index->mObject, index->mBracket, index->mIndex, value);
         }
         Error(*equals, "Invalid assignment target.");
     }
@@ -257,7 +262,7 @@ shared_ptr<Expr> Parser::ParseAssignment()
 }
 
 // logic_or       → logic_and ( "or" logic_and )* ;
-shared_ptr<Expr> Parser::ParseOr()
+Expr *Parser::ParseOr()
 {
     auto expr = ParseAnd();
 
@@ -265,14 +270,14 @@ shared_ptr<Expr> Parser::ParseOr()
     {
         auto op = Previous();
         auto right = ParseAnd();
-        expr = make_shared<Logical>(expr, op, right);
+        expr = mArena.New<Logical>(expr, op, right);
     }
 
     return expr;
 }
 
 // logic_and      → equality ( "and" equality )* ;
-shared_ptr<Expr> Parser::ParseAnd()
+Expr *Parser::ParseAnd()
 {
     auto expr = ParseEquality();
 
@@ -280,14 +285,14 @@ shared_ptr<Expr> Parser::ParseAnd()
     {
         auto op = Previous();
         auto right = ParseEquality();
-        expr = make_shared<Logical>(expr, op, right);
+        expr = mArena.New<Logical>(expr, op, right);
     }
 
     return expr;
 }
 
 // equality       → comparison ( ( "!=" | "==" ) comparison )* ;
-shared_ptr<Expr> Parser::ParseEquality()
+Expr *Parser::ParseEquality()
 {
     auto expr = ParseComparison();
 
@@ -295,13 +300,13 @@ shared_ptr<Expr> Parser::ParseEquality()
     {
         auto op = Previous();
         auto right = ParseComparison();
-        expr = make_shared<Binary>(expr, op, right);
+        expr = mArena.New<Binary>(expr, op, right);
     }
     return expr;
 }
 
 // comparison     → term ( ( ">" | ">=" | "<" | "<=" ) term )* ;
-shared_ptr<Expr> Parser::ParseComparison()
+Expr *Parser::ParseComparison()
 {
     auto expr = ParseTerm();
 
@@ -309,14 +314,14 @@ shared_ptr<Expr> Parser::ParseComparison()
     {
         auto op = Previous();
         auto right = ParseTerm();
-        expr = make_shared<Binary>(expr, op, right);
+        expr = mArena.New<Binary>(expr, op, right);
     }
 
     return expr;
 }
 
 // term           → factor ( ( "-" | "+" ) factor )* ;
-shared_ptr<Expr> Parser::ParseTerm()
+Expr *Parser::ParseTerm()
 {
     auto expr = ParseFactor();
 
@@ -324,13 +329,13 @@ shared_ptr<Expr> Parser::ParseTerm()
     {
         auto op = Previous();
         auto right = ParseFactor();
-        expr = make_shared<Binary>(expr, op, right);
+        expr = mArena.New<Binary>(expr, op, right);
     }
     return expr;
 }
 
 // factor         → unary ( ( "/" | "*" ) unary )* ;
-shared_ptr<Expr> Parser::ParseFactor()
+Expr *Parser::ParseFactor()
 {
     auto expr = ParseUnary();
 
@@ -338,25 +343,25 @@ shared_ptr<Expr> Parser::ParseFactor()
     {
         auto op = Previous();
         auto right = ParseUnary();
-        expr = make_shared<Binary>(expr, op, right);
+        expr = mArena.New<Binary>(expr, op, right);
     }
     return expr;
 }
 
 // unary          → ( "!" | "-" ) unary | call ;
-shared_ptr<Expr> Parser::ParseUnary()
+Expr *Parser::ParseUnary()
 {
     if (Match(vector<TokenType>{TOKEN_BANG, TOKEN_MINUS}))
     {
         auto op = Previous();
         auto right = ParseUnary();
-        return make_shared<Unary>(op, right);
+        return mArena.New<Unary>(op, right);
     }
     return ParseCall();
 }
 
-// call           → primary ( "(" arguments? ")" | "." IDENTIFIER )* ;
-shared_ptr<Expr> Parser::ParseCall()
+// call           → primary ( "(" arguments? ")" | "." IDENTIFIER | "[" expression "]" )* ;
+Expr *Parser::ParseCall()
 {
     auto expr = ParsePrimary();
 
@@ -366,7 +371,14 @@ shared_ptr<Expr> Parser::ParseCall()
         else if (Match(TOKEN_DOT))
         {
             auto name = Consume(TOKEN_IDENTIFIER, "Expect property name after '.'.");
-            expr = make_shared<Get>(expr, name);
+            expr = mArena.New<Get>(expr, name);
+        }
+        else if (Match(TOKEN_LEFT_BRACKET))
+        {
+            auto bracket = Previous();
+            auto index = ParseExpression();
+            Consume(TOKEN_RIGHT_BRACKET, "Expect ']' after index.");
+            expr = mArena.New<Index>(expr, bracket, index);
         }
         else
             break;
@@ -374,9 +386,9 @@ shared_ptr<Expr> Parser::ParseCall()
     return expr;
 }
 
-shared_ptr<Expr> Parser::FinishCall(const shared_ptr<Expr> &callee)
+Expr *Parser::FinishCall(Expr *callee)
 {
-    vector<shared_ptr<Expr>> arguments;
+    vector<Expr *> arguments;
     if (!Check(TOKEN_RIGHT_PAREN))
     {
         do
@@ -389,43 +401,78 @@ shared_ptr<Expr> Parser::FinishCall(const shared_ptr<Expr> &callee)
     }
 
     auto paren = Consume(TOKEN_RIGHT_PAREN, "Expect ')' after arguments.");
-    return make_shared<Call>(callee, paren, arguments);
+    return mArena.New<Call>(callee, paren, arguments);
 }
 
 // primary        → "true" | "false" | "nil" | "this"
 //                | NUMBER | STRING | IDENTIFIER | "(" expression ")"
-//                | "super" "." IDENTIFIER ;
-shared_ptr<Expr> Parser::ParsePrimary()
+//                | "super" "." IDENTIFIER
+//                | "[" ( expression ( "," expression )* )? "]"
+//                | "{" ( entry ( "," entry )* )? "}" ;
+// entry          → expression ":" expression ;
+Expr *Parser::ParsePrimary()
 {
     if (Match(TOKEN_FALSE))
-        return make_shared<Literal>(make_shared<Object>(OBJ_BOOL_FALSE));
+        return mArena.New<Literal>(mArena.New<Object>(OBJ_BOOL_FALSE));
     if (Match(TOKEN_TRUE))
-        return make_shared<Literal>(make_shared<Object>(OBJ_BOOL_TRUE));
+        return mArena.New<Literal>(mArena.New<Object>(OBJ_BOOL_TRUE));
     if (Match(TOKEN_NIL))
-        return make_shared<Literal>(make_shared<Object>());
+        return mArena.New<Literal>(mArena.New<Object>());
 
     if (Match(vector<TokenType>{TOKEN_NUMBER, TOKEN_STRING}))
-        return make_shared<Literal>(make_shared<Object>(Previous()->Literal()));
+        return mArena.New<Literal>(mArena.New<Object>(Previous()->Literal()));
 
     if (Match(TOKEN_SUPER))
     {
         auto keyword = Previous();
         Consume(TOKEN_DOT, "Expect '.' after 'super'.");
         auto method = Consume(TOKEN_IDENTIFIER, "Expect superclass method name.");
-        return make_shared<Super>(keyword, method);
+        return mArena.New<Super>(keyword, method);
     }
 
     if (Match(TOKEN_IDENTIFIER))
-        return make_shared<Variable>(Previous());
+        return mArena.New<Variable>(Previous());
 
     if (Match(TOKEN_THIS))
-        return make_shared<This>(Previous());
+        return mArena.New<This>(Previous());
 
     if (Match(TOKEN_LEFT_PAREN))
     {
         auto expr = ParseExpression();
         Consume(TOKEN_RIGHT_PAREN, "Expect ')' after expression.");
-        return make_shared<Grouping>(expr);
+        return mArena.New<Grouping>(expr);
+    }
+
+    if (Match(TOKEN_LEFT_BRACKET))
+    {
+        auto bracket = Previous();
+        vector<Expr *> elements;
+        if (!Check(TOKEN_RIGHT_BRACKET))
+        {
+            do
+                elements.push_back(ParseExpression());
+            while (Match(TOKEN_COMMA));
+        }
+        Consume(TOKEN_RIGHT_BRACKET, "Expect ']' after list elements.");
+        return mArena.New<ListLiteral>(bracket, elements);
+    }
+
+    if (Match(TOKEN_LEFT_BRACE))
+    {
+        auto brace = Previous();
+        vector<Expr *> keys;
+        vector<Expr *> values;
+        if (!Check(TOKEN_RIGHT_BRACE))
+        {
+            do
+            {
+                keys.push_back(ParseExpression());
+                Consume(TOKEN_COLON, "Expect ':' after map key.");
+                values.push_back(ParseExpression());
+            } while (Match(TOKEN_COMMA));
+        }
+        Consume(TOKEN_RIGHT_BRACE, "Expect '}' after map entries.");
+        return mArena.New<MapLiteral>(brace, keys, values);
     }
 
     throw Error(*Peek(), "Expect expression.");
@@ -458,7 +505,7 @@ bool Parser::Check(const TokenType &type) const
     return Peek()->Type() == type;
 }
 
-shared_ptr<Token> Parser::Advance()
+Token *Parser::Advance()
 {
     if (!IsAtEnd())
     {
@@ -472,17 +519,17 @@ bool Parser::IsAtEnd() const
     return Peek()->Type() == TOKEN_EOF;
 }
 
-shared_ptr<Token> Parser::Peek() const
+Token *Parser::Peek() const
 {
     return mTokens.at(mCurrent);
 }
 
-shared_ptr<Token> Parser::Previous() const
+Token *Parser::Previous() const
 {
     return mTokens.at(mCurrent - 1);
 }
 
-shared_ptr<Token> Parser::Consume(const TokenType &type, const string &message)
+Token *Parser::Consume(const TokenType &type, const string &message)
 {
     if (Check(type))
         return Advance();
@@ -3,6 +3,7 @@
 #include <memory>
 #include <vector>
 
+#include "Arena.h"
 #include "Expr.h"
 #include "Lox.h"
 #include "Stmt.h"
@@ -12,8 +13,6 @@ namespace lox
 {
 
 using std::exception;
-using std::make_shared;
-using std::shared_ptr;
 using std::vector;
 
 class ParseError : public exception
@@ -36,53 +35,55 @@ class ParseError : public exception
 class Parser
 {
   public:
-    Parser(const vector<shared_ptr<Token>> &tokens) : mTokens(tokens)
+    // nodes are allocated from arena, which usually is the one the tokens came from
+    Parser(const vector<Token *> &tokens, Arena &arena) : mTokens(tokens), mArena(arena)
     {
     }
-    vector<shared_ptr<Stmt>> Parse();
+    vector<Stmt *> Parse();
 
     /* public scope for test */
-    shared_ptr<Stmt> ParseDeclaration();
-    shared_ptr<Stmt> ParseClassDeclaration();
-    shared_ptr<Stmt> ParseFunction(const string &kind);
-    shared_ptr<Stmt> ParseVarDeclaration();
+    Stmt *ParseDeclaration();
+    Stmt *ParseClassDeclaration();
+    Stmt *ParseFunction(const string &kind);
+    Stmt *ParseVarDeclaration();
 
-    shared_ptr<Stmt> ParseStatement();
-    shared_ptr<Stmt> ParsePrintStatement();
-    shared_ptr<Stmt> ParseExpressionStatement();
-    shared_ptr<Stmt> ParseBlock();
-    shared_ptr<Stmt> ParseForStatement();
-    shared_ptr<Stmt> ParseIfStatement();
-    shared_ptr<Stmt> ParseReturnStatement();
-    shared_ptr<Stmt> ParseWhileStatement();
+    Stmt *ParseStatement();
+    Stmt *ParsePrintStatement();
+    Stmt *ParseExpressionStatement();
+    Stmt *ParseBlock();
+    Stmt *ParseForStatement();
+    Stmt *ParseIfStatement();
+    Stmt *ParseReturnStatement();
+    Stmt *ParseWhileStatement();
 
-    shared_ptr<Expr> ParseExpression();
-    shared_ptr<Expr> ParseAssignment();
-    shared_ptr<Expr> ParseOr();
-    shared_ptr<Expr> ParseAnd();
-    shared_ptr<Expr> ParseEquality();
-    shared_ptr<Expr> ParseComparison();
-    shared_ptr<Expr> ParseTerm();
-    shared_ptr<Expr> ParseFactor();
-    shared_ptr<Expr> ParseUnary();
-    shared_ptr<Expr> ParseCall();
-    shared_ptr<Expr> ParsePrimary();
+    Expr *ParseExpression();
+    Expr *ParseAssignment();
+    Expr *ParseOr();
+    Expr *ParseAnd();
+    Expr *ParseEquality();
+    Expr *ParseComparison();
+    Expr *ParseTerm();
+    Expr *ParseFactor();
+    Expr *ParseUnary();
+    Expr *ParseCall();
+    Expr *ParsePrimary();
 
   private:
     bool Match(const TokenType &type);
     bool Match(const vector<TokenType> &types);
 
     bool Check(const TokenType &type) const;
-    shared_ptr<Token> Advance();
+    Token *Advance();
     bool IsAtEnd() const;
-    shared_ptr<Token> Peek() const;
-    shared_ptr<Token> Previous() const;
-    shared_ptr<Token> Consume(const TokenType &type, const string &message);
+    Token *Peek() const;
+    Token *Previous() const;
+    Token *Consume(const TokenType &type, const string &message);
     ParseError Error(const Token &token, const string &message) const;
     void Synchronize();
-    shared_ptr<Expr> FinishCall(const shared_ptr<Expr> &callee);
+    Expr *FinishCall(Expr *callee);
 
-    const vector<shared_ptr<Token>> mTokens;
+    const vector<Token *> mTokens;
+    Arena &mArena;
     int mCurrent = 0;
 };
 
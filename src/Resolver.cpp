@@ -1,11 +1,12 @@
 #include "Resolver.h"
 #include "Lox.h"
+#include <algorithm>
 #include <iostream>
 
 namespace lox
 {
 
-void Resolver::Resolve(const vector<shared_ptr<Stmt>> &statements)
+void Resolver::Resolve(const vector<Stmt *> &statements)
 {
     for (auto stmt : statements)
         Resolve(*stmt);
@@ -22,7 +23,7 @@ void Resolver::Visit(const Print &stmt)
 
 void Resolver::Visit(const Var &stmt)
 {
-    Declare(*stmt.mName);
+    Declare(*stmt.mName, &stmt.mSlot);
     if (stmt.mInitializer)
         Resolve(*stmt.mInitializer);
     Define(*stmt.mName);
@@ -51,7 +52,7 @@ void Resolver::Visit(const While &stmt)
 
 void Resolver::Visit(const Function &stmt)
 {
-    Declare(*stmt.mName);
+    Declare(*stmt.mName, &stmt.mSlot);
     Define(*stmt.mName);
 
     ResolveFunction(stmt, FUNCTION_FUNCTION);
@@ -74,9 +75,12 @@ void Resolver::Visit(const Return &stmt)
 void Resolver::Visit(const Class &stmt)
 {
     auto enclosingClass = mCurrentClass;
+    auto enclosingClassStmt = mClass;
     mCurrentClass = CLASS_CLASS;
+    mClass = &stmt;
+    stmt.mSuperMethods.clear();
 
-    Declare(*stmt.mName);
+    Declare(*stmt.mName, &stmt.mSlot);
     Define(*stmt.mName);
 
     if (stmt.mSuperclass && stmt.mName->Lexeme() == stmt.mSuperclass->mName->Lexeme())
@@ -90,28 +94,25 @@ void Resolver::Visit(const Class &stmt)
 
     if (stmt.mSuperclass)
     {
+        // "super" holds the class itself, which keeps the methods its super expressions refer to
         BeginScope();
-        mScopes.front()["super"] = true;
+        DeclareImplicit("super", &stmt.mSuperSlot);
     }
 
-    BeginScope();
-    mScopes.front()["this"] = true;
-
     for (auto method : stmt.mMethods)
         ResolveFunction(*method, method->mName->Lexeme() == "init" ? FUNCTION_INITIALIZER : FUNCTION_METHOD);
 
-    EndScope();
-
     if (stmt.mSuperclass)
         EndScope();
 
     mCurrentClass = enclosingClass;
+    mClass = enclosingClassStmt;
 }
 
 void Resolver::Visit(const Assign &expr)
 {
     Resolve(*expr.mValue);
-    ResolveLocal(expr, *expr.mName);
+    ResolveLocal(expr.mName->Lexeme(), expr.mSlot);
 }
 
 void Resolver::Visit(const Binary &expr)
@@ -137,6 +138,18 @@ void Resolver::Visit(const Grouping &expr)
     Resolve(*expr.mExpression);
 }
 
+void Resolver::Visit(const Index &expr)
+{
+    Resolve(*expr.mObject);
+    Resolve(*expr.mIndex);
+}
+
+void Resolver::Visit(const ListLiteral &expr)
+{
+    for (auto element : expr.mElements)
+        Resolve(*element);
+}
+
 void Resolver::Visit(const Literal &expr)
 {
     // no work to do for Literal
@@ -148,20 +161,42 @@ void Resolver::Visit(const Logical &expr)
     Resolve(*expr.mRight);
 }
 
+void Resolver::Visit(const MapLiteral &expr)
+{
+    for (size_t i = 0; i < expr.mKeys.size(); i++)
+    {
+        Resolve(*expr.mKeys[i]);
+        Resolve(*expr.mValues[i]);
+    }
+}
+
 void Resolver::Visit(const Set &expr)
 {
     Resolve(*expr.mValue);
     Resolve(*expr.mObject);
 }
 
+void Resolver::Visit(const SetIndex &expr)
+{
+    Resolve(*expr.mValue);
+    Resolve(*expr.mObject);
+    Resolve(*expr.mIndex);
+}
+
 void Resolver::Visit(const Super &expr)
 {
     if (mCurrentClass == CLASS_NONE)
         Lox::Error(*expr.mKeyword, "Can't use 'super' outside of a class.");
     else if (mCurrentClass != CLASS_SUBCLASS)
         Lox::Error(*expr.mKeyword, "Can't use 'super' in a class with no superclass.");
+    else
+    {
+        expr.mTarget = static_cast<int>(mClass->mSuperMethods.size());
+        mClass->mSuperMethods.push_back(expr.mMethod);
+    }
 
-    ResolveLocal(expr, *expr.mKeyword);
+    ResolveLocal("super", expr.mSlot);
+    ResolveLocal("this", expr.mReceiver);
 }
 
 void Resolver::Visit(const This &expr)
@@ -172,7 +207,7 @@ void Resolver::Visit(const This &expr)
         return;
     }
 
-    ResolveLocal(expr, *expr.mKeyword);
+    ResolveLocal("this", expr.mSlot);
 }
 
 void Resolver::Visit(const Unary &expr)
@@ -184,12 +219,13 @@ void Resolver::Visit(const Variable &expr)
 {
     if (!mScopes.empty())
     {
-        auto &topScope = mScopes.front();
-        if (topScope.contains(expr.mName->Lexeme()) && topScope[expr.mName->Lexeme()] == false)
+        auto &variables = mScopes.back().mVariables;
+        auto found = variables.find(expr.mName->Lexeme());
+        if (found != variables.end() && !found->second.mDefined)
             Lox::Error(*expr.mName, "Can't read local variable in its own initializer.");
     }
 
-    ResolveLocal(expr, *expr.mName);
+    ResolveLocal(expr.mName->Lexeme(), expr.mSlot);
 }
 
 void Resolver::Resolve(const Stmt &stmt)
@@ -204,43 +240,121 @@ void Resolver::Resolve(const Expr &expr)
 
 void Resolver::BeginScope()
 {
-    mScopes.push_front(unordered_map<string, bool>());
+    mScopes.push_back(Scope{{}, mFunctions.back().mSlotCount});
 }
 
 void Resolver::EndScope()
 {
-    mScopes.pop_front();
+    // the variables of the scope are dead once it ends, the scopes after it may reuse their slots
+    auto &function = mFunctions.back();
+    function.mMaxSlotCount = std::max(function.mMaxSlotCount, function.mSlotCount);
+    function.mSlotCount = mScopes.back().mFirstSlot;
+    mScopes.pop_back();
 }
 
-void Resolver::Declare(const Token &name)
+void Resolver::Declare(const Token &name, Slot *slot)
 {
+    // globals stay unresolved
     if (mScopes.empty())
         return;
-    auto &scope = mScopes.front();
 
-    if (scope.contains(name.Lexeme()))
+    if (mScopes.back().mVariables.contains(name.Lexeme()))
+    {
         Lox::Error(name, "Already variable with this name in this scope.");
-
-    scope[name.Lexeme()] = false;
+        return;
+    }
+    AddVariable(name.Lexeme(), slot);
 }
 
 void Resolver::Define(const Token &name)
 {
     if (mScopes.empty())
         return;
-    mScopes.front()[name.Lexeme()] = true;
+    mScopes.back().mVariables[name.Lexeme()].mDefined = true;
 }
 
-void Resolver::ResolveLocal(const Expr &expr, const Token &name)
+void Resolver::DeclareImplicit(const string &name, Slot *slot)
 {
-    for (size_t i = 0; i < mScopes.size(); i++)
+    AddVariable(name, slot).mDefined = true;
+}
+
+ScopeVariable &Resolver::AddVariable(const string &name, Slot *slot)
+{
+    auto index = mFunctions.back().mSlotCount++;
+    auto &variable = mScopes.back().mVariables[name];
+    variable = ScopeVariable{false, index};
+    if (slot)
+    {
+        *slot = Slot{SLOT_LOCAL, index};
+        variable.mReferences.push_back(slot);
+    }
+    return variable;
+}
+
+void Resolver::ResolveLocal(const string &name, Slot &slot)
+{
+    auto &function = mFunctions.back();
+    for (auto i = mScopes.size(); i-- > function.mFirstScope;)
+    {
+        auto found = mScopes[i].mVariables.find(name);
+        if (found == mScopes[i].mVariables.end())
+            continue;
+
+        auto &variable = found->second;
+        slot = Slot{variable.mCaptured ? SLOT_CELL : SLOT_LOCAL, variable.mSlot};
+        if (!variable.mCaptured)
+            variable.mReferences.push_back(&slot);
+        return;
+    }
+
+    auto upvalue = ResolveUpvalue(mFunctions.size() - 1, name);
+    // not found anywhere, assume it is global
+    slot = upvalue < 0 ? Slot() : Slot{SLOT_UPVALUE, upvalue};
+}
+
+int Resolver::ResolveUpvalue(size_t function, const string &name)
+{
+    if (function == 0)
+        return -1;
+
+    auto &enclosing = mFunctions[function - 1];
+    for (auto i = mFunctions[function].mFirstScope; i-- > enclosing.mFirstScope;)
     {
-        if (mScopes.at(i).contains(name.Lexeme()))
+        auto found = mScopes[i].mVariables.find(name);
+        if (found != mScopes[i].mVariables.end())
         {
-            mInterpreter.Resolve(expr, i);
-            return;
+            MarkCaptured(found->second);
+            return AddUpvalue(mFunctions[function], Capture{true, found->second.mSlot});
         }
     }
+
+    auto upvalue = ResolveUpvalue(function - 1, name);
+    if (upvalue < 0)
+        return -1;
+    return AddUpvalue(mFunctions[function], Capture{false, upvalue});
+}
+
+int Resolver::AddUpvalue(FunctionScope &function, const Capture &capture)
+{
+    auto &upvalues = function.mUpvalues;
+    for (size_t i = 0; i < upvalues.size(); i++)
+    {
+        if (upvalues[i].mIsLocal == capture.mIsLocal && upvalues[i].mIndex == capture.mIndex)
+            return static_cast<int>(i);
+    }
+    upvalues.push_back(capture);
+    return static_cast<int>(upvalues.size() - 1);
+}
+
+// the variable moves into a cell, which the sites resolved to it so far have to go through too
+void Resolver::MarkCaptured(ScopeVariable &variable)
+{
+    if (variable.mCaptured)
+        return;
+    variable.mCaptured = true;
+    for (auto slot : variable.mReferences)
+        slot->mKind = SLOT_CELL;
+    variable.mReferences.clear();
 }
 
 void Resolver::ResolveFunction(const Function &func, FunctionType type)
@@ -248,15 +362,33 @@ void Resolver::ResolveFunction(const Function &func, FunctionType type)
     auto enclosingFunction = mCurrentFunction;
     mCurrentFunction = type;
 
+    mFunctions.push_back(FunctionScope{mScopes.size()});
     BeginScope();
+    // a method receives "this" in the first slot of its own frame, ahead of the parameters
+    auto isMethod = type == FUNCTION_METHOD || type == FUNCTION_INITIALIZER;
+    if (isMethod)
+        DeclareImplicit("this", nullptr);
     for (auto param : func.mParams)
     {
         Declare(*param);
         Define(*param);
     }
     Resolve(func.mBody);
+
+    // the receiver and the parameters are not declared by a statement, the call puts the captured ones in cells
+    auto &frame = func.mFrame;
+    frame.mCells.clear();
+    for (auto &[name, variable] : mScopes.back().mVariables)
+    {
+        if (variable.mCaptured && variable.mSlot < static_cast<int>(func.mParams.size()) + isMethod)
+            frame.mCells.push_back(variable.mSlot);
+    }
     EndScope();
 
+    frame.mSize = mFunctions.back().mMaxSlotCount;
+    frame.mUpvalues = std::move(mFunctions.back().mUpvalues);
+    mFunctions.pop_back();
+
     mCurrentFunction = enclosingFunction;
 }
 
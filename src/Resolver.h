@@ -3,24 +3,15 @@
 #include "Expr.h"
 #include "Interpreter.h"
 #include "Stmt.h"
-#include <deque>
 #include <unordered_map>
+#include <vector>
 
 namespace lox
 {
 
-using std::deque;
 using std::string;
 using std::unordered_map;
 
-enum FunctionType
-{
-    FUNCTION_NONE,
-    FUNCTION_FUNCTION,
-    FUNCTION_INITIALIZER,
-    FUNCTION_METHOD,
-};
-
 enum ClassType
 {
     CLASS_NONE,
@@ -28,14 +19,47 @@ enum ClassType
     CLASS_SUBCLASS,
 };
 
+// A variable declared in a resolver scope. mSlot is its index in the frame of the function declaring it.
+struct ScopeVariable
+{
+    bool mDefined;
+    int mSlot;
+    // whether a closure captures the variable, which then lives in a cell
+    bool mCaptured = false;
+    // the sites resolved to the variable before it was known to be captured, which then have to use its cell
+    vector<Slot *> mReferences;
+};
+
+// A block scope. Its variables take slots of the frame of its function, which are free again when it ends.
+struct Scope
+{
+    unordered_map<string, ScopeVariable> mVariables;
+    // the first slot the scope took from the frame
+    int mFirstSlot = 0;
+};
+
+// A function being resolved. Top level code is resolved as a function too, so that the locals of its blocks get
+// slots of the frame top level code runs in.
+struct FunctionScope
+{
+    // mScopes from this index on belong to the function
+    size_t mFirstScope;
+    // slots of the frame in use
+    int mSlotCount = 0;
+    // the most slots of the frame ever in use at once
+    int mMaxSlotCount = 0;
+    vector<Capture> mUpvalues;
+};
+
 class Resolver : public Expr::Visitor<void>, public Stmt::Visitor<void>
 {
   public:
-    Resolver(Interpreter &interpreter) : mInterpreter(interpreter)
+    // reports static errors and annotates variable references with the Slot they resolve to
+    Resolver() : mFunctions{FunctionScope{0}}
     {
     }
 
-    void Resolve(const vector<shared_ptr<Stmt>> &statements);
+    void Resolve(const vector<Stmt *> &statements);
 
     void Visit(const Expression &stmt);
     void Visit(const Print &stmt);
@@ -52,9 +76,13 @@ class Resolver : public Expr::Visitor<void>, public Stmt::Visitor<void>
     void Visit(const Call &expr);
     void Visit(const Get &expr);
     void Visit(const Grouping &expr);
+    void Visit(const Index &expr);
+    void Visit(const ListLiteral &expr);
     void Visit(const Literal &expr);
     void Visit(const Logical &expr);
+    void Visit(const MapLiteral &expr);
     void Visit(const Set &expr);
+    void Visit(const SetIndex &expr);
     void Visit(const Super &expr);
     void Visit(const This &expr);
     void Visit(const Unary &expr);
@@ -65,16 +93,27 @@ class Resolver : public Expr::Visitor<void>, public Stmt::Visitor<void>
     void Resolve(const Expr &expr);
     void BeginScope();
     void EndScope();
-    void Declare(const Token &name);
+    // declares a variable in the innermost scope, slot is where its declaration stores the value if it has one
+    void Declare(const Token &name, Slot *slot = nullptr);
     void Define(const Token &name);
-    void ResolveLocal(const Expr &expr, const Token &name);
+    // declares and defines "this" or "super", which the user cannot declare
+    void DeclareImplicit(const string &name, Slot *slot);
+    ScopeVariable &AddVariable(const string &name, Slot *slot);
+    void ResolveLocal(const string &name, Slot &slot);
+    // the upvalue index of the variable a function of mFunctions refers to by name, -1 for a global
+    int ResolveUpvalue(size_t function, const string &name);
+    int AddUpvalue(FunctionScope &function, const Capture &capture);
+    void MarkCaptured(ScopeVariable &variable);
     void ResolveFunction(const Function &func, FunctionType type);
 
-    Interpreter &mInterpreter;
-    deque<unordered_map<string, bool>> mScopes;
+    // innermost last
+    vector<Scope> mScopes;
+    vector<FunctionScope> mFunctions;
 
     FunctionType mCurrentFunction = FUNCTION_NONE;
     ClassType mCurrentClass = CLASS_NONE;
+    // the class the methods being resolved belong to, which collects the targets of their super expressions
+    const Class *mClass = nullptr;
 };
 
 } // namespace lox
@@ -5,7 +5,7 @@
 namespace lox
 {
 
-const vector<shared_ptr<Token>> &Scanner::ScanTokens()
+const vector<Token *> &Scanner::ScanTokens()
 {
     while (!IsAtEnd())
     {
@@ -13,7 +13,7 @@ const vector<shared_ptr<Token>> &Scanner::ScanTokens()
         ScanToken();
     }
 
-    mTokens.push_back(make_shared<Token>(TOKEN_EOF, "", "", mLine));
+    mTokens.push_back(mArena.New<Token>(TOKEN_EOF, "", "", mLine));
     return mTokens;
 }
 
@@ -34,9 +34,18 @@ void Scanner::ScanToken()
     case '}':
         AddToken(TOKEN_RIGHT_BRACE);
         break;
+    case '[':
+        AddToken(TOKEN_LEFT_BRACKET);
+        break;
+    case ']':
+        AddToken(TOKEN_RIGHT_BRACKET);
+        break;
     case ',':
         AddToken(TOKEN_COMMA);
         break;
+    case ':':
+        AddToken(TOKEN_COLON);
+        break;
     case '.':
         AddToken(TOKEN_DOT);
         break;
@@ -129,7 +138,7 @@ void Scanner::AddToken(TokenType type)
 template <typename L> void Scanner::AddToken(TokenType type, const L &literal)
 {
     string text = mSource.substr(mStart, mCurrent - mStart);
-    mTokens.push_back(make_shared<Token>(type, text, literal, mLine));
+    mTokens.push_back(mArena.New<Token>(type, text, literal, mLine));
 }
 
 bool Scanner::Match(const char &expected)
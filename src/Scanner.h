@@ -4,13 +4,12 @@
 #include <unordered_map>
 #include <vector>
 
+#include "Arena.h"
 #include "Token.h"
 
 namespace lox
 {
 
-using std::make_shared;
-using std::shared_ptr;
 using std::stod;
 using std::unordered_map;
 using std::vector;
@@ -18,11 +17,12 @@ using std::vector;
 class Scanner
 {
   public:
-    Scanner(const string &source) : mSource(source)
+    // the tokens are allocated from arena and live as long as it does
+    Scanner(const string &source, Arena &arena) : mSource(source), mArena(arena)
     {
     }
 
-    const vector<shared_ptr<Token>> &ScanTokens();
+    const vector<Token *> &ScanTokens();
 
   private:
     inline static const unordered_map<string, TokenType> sKeywords = {
@@ -48,7 +48,8 @@ class Scanner
     void Identifier();
 
     string mSource;
-    vector<shared_ptr<Token>> mTokens;
+    Arena &mArena;
+    vector<Token *> mTokens;
 
     size_t mStart = 0;
     size_t mCurrent = 0;
@@ -0,0 +1,26 @@
+#include "Shape.h"
+
+namespace lox
+{
+
+Shape::Shape(const Shape *parent) : mId(sNextId++)
+{
+    if (parent)
+        mSlots = parent->mSlots;
+    sStats.mShapes++;
+}
+
+Shape *Shape::Transition(const HashedString &name)
+{
+    auto found = mTransitions.find(name);
+    if (found != mTransitions.end())
+        return found->second.get();
+
+    auto next = new Shape(this);
+    next->mSlots.emplace(name.mString, SlotCount());
+    mTransitions.emplace(name.mString, next);
+    sStats.mTransitions++;
+    return next;
+}
+
+} // namespace lox
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "StringHash.h"
+
+namespace lox
+{
+
+using std::string;
+using std::unique_ptr;
+
+class Value;
+
+// counted over the whole process
+struct ShapeStats
+{
+    size_t mShapes = 0;
+    size_t mTransitions = 0;
+    size_t mMegamorphicSites = 0;
+};
+
+// Hidden class of a LoxInstance: maps field names to slots in the instance's field storage.
+// Every class owns the root of a transition tree. Instances of a class that add their fields in the same order walk
+// the same transitions, so they end up sharing a shape.
+// Ids are never reused, so a cache keyed on the id cannot mistake a new shape for one freed with its class.
+class Shape
+{
+  public:
+    Shape() : Shape(nullptr)
+    {
+    }
+    Shape(const Shape &) = delete;
+    Shape &operator=(const Shape &) = delete;
+
+    // slot of the field, -1 if this shape has no such field
+    int Lookup(const HashedString &name) const
+    {
+        auto found = mSlots.find(name);
+        return found == mSlots.end() ? -1 : found->second;
+    }
+    // shape after adding the field, the new field takes slot SlotCount()
+    Shape *Transition(const HashedString &name);
+
+    int SlotCount() const
+    {
+        return static_cast<int>(mSlots.size());
+    }
+    uint64_t Id() const
+    {
+        return mId;
+    }
+
+    static const ShapeStats &Stats()
+    {
+        return sStats;
+    }
+
+  private:
+    friend class PropertySite;
+
+    Shape(const Shape *parent);
+
+    uint64_t mId;
+    StringMap<int> mSlots;
+    StringMap<unique_ptr<Shape>> mTransitions;
+
+    inline static ShapeStats sStats;
+    inline static uint64_t sNextId = 0;
+};
+
+struct PropertyCacheEntry
+{
+    uint64_t mShapeId;
+    // slot of the field, -1 when the property is a method
+    int mSlot;
+    // method found on the class when there is no such field
+    const Value *mMethod;
+    // for a Set that adds the field: the shape after the transition
+    Shape *mTransition;
+};
+
+// Inline cache of one property access in the source, keyed on the receiver's shape.
+// Since every class has its own shapes, the shape also determines the class and so the method a name resolves to.
+// A site that keeps seeing new shapes goes megamorphic and stops caching.
+class PropertySite
+{
+  public:
+    static constexpr int MAX_SHAPES = 4;
+
+    const PropertyCacheEntry *Find(const Shape *shape) const
+    {
+        for (int i = 0; i < mEntryCount; i++)
+        {
+            if (mEntries[i].mShapeId == shape->Id())
+                return &mEntries[i];
+        }
+        return nullptr;
+    }
+
+    void Add(const PropertyCacheEntry &entry)
+    {
+        if (mMegamorphic)
+            return;
+        if (mEntryCount == MAX_SHAPES)
+        {
+            mMegamorphic = true;
+            Shape::sStats.mMegamorphicSites++;
+            return;
+        }
+        mEntries[mEntryCount++] = entry;
+    }
+
+    bool IsMonomorphic() const
+    {
+        return mEntryCount == 1;
+    }
+    bool IsMegamorphic() const
+    {
+        return mMegamorphic;
+    }
+
+  private:
+    PropertyCacheEntry mEntries[MAX_SHAPES];
+    int mEntryCount = 0;
+    bool mMegamorphic = false;
+};
+
+} // namespace lox
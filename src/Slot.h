@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+
+namespace lox
+{
+
+using std::vector;
+
+class LoxString;
+
+enum SlotKind
+{
+    // looked up by name in the globals
+    SLOT_GLOBAL,
+    // a value in the frame of the running function
+    SLOT_LOCAL,
+    // a slot of the frame holding the LoxCell of a variable some closure captures
+    SLOT_CELL,
+    // a cell the running closure captured when it was created
+    SLOT_UPVALUE,
+};
+
+// Where a resolved variable lives, and its index in the frame or in the upvalues of the running closure.
+// A default constructed Slot is unresolved, meaning the variable is a global.
+struct Slot
+{
+    SlotKind mKind = SLOT_GLOBAL;
+    int mIndex = 0;
+
+    bool IsResolved() const
+    {
+        return mKind != SLOT_GLOBAL;
+    }
+};
+
+// Inline cache of a site naming a global variable: the slot of the global in the GlobalTable, -1 until the site first
+// runs. Slots are stable, so the cache never needs to be invalidated.
+struct GlobalSite
+{
+    int mSlot = -1;
+};
+
+// Inline cache of a string literal: the interned string it evaluates to, nullptr until the literal first runs.
+struct StringSite
+{
+    LoxString *mString = nullptr;
+};
+
+// A variable a closure captures when it is created: the cell in a frame slot of the function creating it, or one of
+// the upvalues of that function.
+struct Capture
+{
+    bool mIsLocal;
+    int mIndex;
+};
+
+// Layout of the frame a call to a function runs in, so that a call can set up all of its slots at once.
+// mSize counts the receiver, the parameters and every local of the body, blocks included.
+struct FrameLayout
+{
+    int mSize = 0;
+    // slots of the receiver and the parameters which closures capture, their values go into cells on entry
+    vector<int> mCells;
+    // what a closure of the function captures, in upvalue order
+    vector<Capture> mUpvalues;
+};
+
+} // namespace lox
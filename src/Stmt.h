@@ -1,6 +1,7 @@
 
 #pragma once
 
+#include "Completion.h"
 #include "Expr.h"
 #include "Value.h"
 #include <memory>
@@ -8,7 +9,8 @@
 
 #define V_STMT_ACCEPT_METHODS                                                                                          \
     virtual string Accept(Visitor<string> &visitor) const = 0;                                                         \
-    virtual void Accept(Visitor<void> &visitor) const = 0;
+    virtual void Accept(Visitor<void> &visitor) const = 0;                                                             \
+    virtual Completion Accept(Visitor<Completion> &visitor) const = 0;
 
 #define STMT_ACCEPT_METHODS                                                                                            \
     string Accept(Visitor<string> &visitor) const override                                                             \
@@ -16,6 +18,10 @@
         return visitor.Visit(*this);                                                                                   \
     }                                                                                                                  \
     void Accept(Visitor<void> &visitor) const override                                                                 \
+    {                                                                                                                  \
+        return visitor.Visit(*this);                                                                                   \
+    }                                                                                                                  \
+    Completion Accept(Visitor<Completion> &visitor) const override                                                     \
     {                                                                                                                  \
         return visitor.Visit(*this);                                                                                   \
     }
@@ -23,7 +29,6 @@
 namespace lox
 {
 
-using std::shared_ptr;
 using std::vector;
 
 class Block;
@@ -59,11 +64,11 @@ class Stmt
 class Block : public Stmt
 {
   public:
-    Block(const vector<shared_ptr<Stmt>> &statements) : mStatements(statements)
+    Block(const vector<Stmt *> &statements) : mStatements(statements)
     {
     }
 
-    vector<shared_ptr<Stmt>> mStatements;
+    vector<Stmt *> mStatements;
 
     STMT_ACCEPT_METHODS
 };
@@ -71,15 +76,17 @@ class Block : public Stmt
 class Class : public Stmt
 {
   public:
-    Class(const shared_ptr<Token> &name, const shared_ptr<Variable> &superclass,
-          const vector<shared_ptr<Function>> &methods)
+    Class(Token *name, Variable *superclass, const vector<Function *> &methods)
         : mName(name), mSuperclass(superclass), mMethods(methods)
     {
     }
 
-    shared_ptr<Token> mName;
-    shared_ptr<Variable> mSuperclass;
-    vector<shared_ptr<Function>> mMethods;
+    Token *mName;
+    Variable *mSuperclass;
+    vector<Function *> mMethods;
+    mutable Slot mSlot;
+    mutable Slot mSuperSlot;
+    mutable vector<Token *> mSuperMethods;
 
     STMT_ACCEPT_METHODS
 };
@@ -87,11 +94,11 @@ class Class : public Stmt
 class Expression : public Stmt
 {
   public:
-    Expression(const shared_ptr<Expr> &expression) : mExpression(expression)
+    Expression(Expr *expression) : mExpression(expression)
     {
     }
 
-    shared_ptr<Expr> mExpression;
+    Expr *mExpression;
 
     STMT_ACCEPT_METHODS
 };
@@ -99,15 +106,16 @@ class Expression : public Stmt
 class Function : public Stmt
 {
   public:
-    Function(const shared_ptr<Token> &name, const vector<shared_ptr<Token>> &params,
-             const vector<shared_ptr<Stmt>> &body)
+    Function(Token *name, const vector<Token *> &params, const vector<Stmt *> &body)
         : mName(name), mParams(params), mBody(body)
     {
     }
 
-    shared_ptr<Token> mName;
-    vector<shared_ptr<Token>> mParams;
-    vector<shared_ptr<Stmt>> mBody;
+    Token *mName;
+    vector<Token *> mParams;
+    vector<Stmt *> mBody;
+    mutable Slot mSlot;
+    mutable FrameLayout mFrame;
 
     STMT_ACCEPT_METHODS
 };
@@ -115,14 +123,14 @@ class Function : public Stmt
 class If : public Stmt
 {
   public:
-    If(const shared_ptr<Expr> &condition, const shared_ptr<Stmt> &thenBranch, const shared_ptr<Stmt> &elseBranch)
+    If(Expr *condition, Stmt *thenBranch, Stmt *elseBranch)
         : mCondition(condition), mThenBranch(thenBranch), mElseBranch(elseBranch)
     {
     }
 
-    shared_ptr<Expr> mCondition;
-    shared_ptr<Stmt> mThenBranch;
-    shared_ptr<Stmt> mElseBranch;
+    Expr *mCondition;
+    Stmt *mThenBranch;
+    Stmt *mElseBranch;
 
     STMT_ACCEPT_METHODS
 };
@@ -130,11 +138,11 @@ class If : public Stmt
 class Print : public Stmt
 {
   public:
-    Print(const shared_ptr<Expr> &expression) : mExpression(expression)
+    Print(Expr *expression) : mExpression(expression)
     {
     }
 
-    shared_ptr<Expr> mExpression;
+    Expr *mExpression;
 
     STMT_ACCEPT_METHODS
 };
@@ -142,12 +150,12 @@ class Print : public Stmt
 class Return : public Stmt
 {
   public:
-    Return(const shared_ptr<Token> &keyword, const shared_ptr<Expr> &value) : mKeyword(keyword), mValue(value)
+    Return(Token *keyword, Expr *value) : mKeyword(keyword), mValue(value)
     {
     }
 
-    shared_ptr<Token> mKeyword;
-    shared_ptr<Expr> mValue;
+    Token *mKeyword;
+    Expr *mValue;
 
     STMT_ACCEPT_METHODS
 };
@@ -155,12 +163,13 @@ class Return : public Stmt
 class Var : public Stmt
 {
   public:
-    Var(const shared_ptr<Token> &name, const shared_ptr<Expr> &initializer) : mName(name), mInitializer(initializer)
+    Var(Token *name, Expr *initializer) : mName(name), mInitializer(initializer)
     {
     }
 
-    shared_ptr<Token> mName;
-    shared_ptr<Expr> mInitializer;
+    Token *mName;
+    Expr *mInitializer;
+    mutable Slot mSlot;
 
     STMT_ACCEPT_METHODS
 };
@@ -168,12 +177,12 @@ class Var : public Stmt
 class While : public Stmt
 {
   public:
-    While(const shared_ptr<Expr> &condition, const shared_ptr<Stmt> &body) : mCondition(condition), mBody(body)
+    While(Expr *condition, Stmt *body) : mCondition(condition), mBody(body)
     {
     }
 
-    shared_ptr<Expr> mCondition;
-    shared_ptr<Stmt> mBody;
+    Expr *mCondition;
+    Stmt *mBody;
 
     STMT_ACCEPT_METHODS
 };
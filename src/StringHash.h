@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace lox
+{
+
+using std::string;
+using std::string_view;
+
+// FNV-1a, the hash every name and runtime string is keyed by
+inline uint32_t HashString(string_view str)
+{
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : str)
+    {
+        hash ^= c;
+        hash *= 16777619;
+    }
+    return hash;
+}
+
+// A string together with its precomputed hash.
+// Tokens and runtime strings hash themselves once and look names up through this, so the tables below never hash a
+// key that already knows its hash. Plain strings convert implicitly, paying for the hash on the spot.
+struct HashedString
+{
+    HashedString(string_view str, uint32_t hash) : mString(str), mHash(hash)
+    {
+    }
+    HashedString(const string &str) : HashedString(str, HashString(str))
+    {
+    }
+    HashedString(const char *str) : HashedString(str, HashString(str))
+    {
+    }
+
+    string_view mString;
+    uint32_t mHash;
+};
+
+struct StringHasher
+{
+    using is_transparent = void;
+
+    size_t operator()(const string &str) const
+    {
+        return HashString(str);
+    }
+    size_t operator()(const HashedString &str) const
+    {
+        return str.mHash;
+    }
+};
+
+struct StringEqual
+{
+    using is_transparent = void;
+
+    bool operator()(const string &a, const string &b) const
+    {
+        return a == b;
+    }
+    bool operator()(const HashedString &a, const string &b) const
+    {
+        return a.mString == b;
+    }
+    bool operator()(const string &a, const HashedString &b) const
+    {
+        return a == b.mString;
+    }
+};
+
+// map keyed by names, looked up with either a string or a HashedString
+template <typename T> using StringMap = std::unordered_map<string, T, StringHasher, StringEqual>;
+
+} // namespace lox
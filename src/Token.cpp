@@ -19,9 +19,18 @@ std::ostream &operator<<(std::ostream &cout, const Token &token)
     case TOKEN_RIGHT_BRACE:
         cout << "RIGHT_BRACE";
         break;
+    case TOKEN_LEFT_BRACKET:
+        cout << "LEFT_BRACKET";
+        break;
+    case TOKEN_RIGHT_BRACKET:
+        cout << "RIGHT_BRACKET";
+        break;
     case TOKEN_COMMA:
         cout << "COMMA";
         break;
+    case TOKEN_COLON:
+        cout << "COLON";
+        break;
     case TOKEN_DOT:
         cout << "DOT";
         break;
@@ -4,6 +4,7 @@
 #include <string>
 
 #include "Object.h"
+#include "StringHash.h"
 
 namespace lox
 {
@@ -17,7 +18,10 @@ enum TokenType
     TOKEN_RIGHT_PAREN,
     TOKEN_LEFT_BRACE,
     TOKEN_RIGHT_BRACE,
+    TOKEN_LEFT_BRACKET,
+    TOKEN_RIGHT_BRACKET,
     TOKEN_COMMA,
+    TOKEN_COLON,
     TOKEN_DOT,
     TOKEN_MINUS,
     TOKEN_PLUS,
@@ -65,12 +69,12 @@ class Token
 {
   public:
     Token(TokenType type, const string &lexeme, const string &literal, int line)
-        : mType(type), mLexeme(lexeme), mLiteral(Object(literal)), mLine(line)
+        : mType(type), mLexeme(lexeme), mLiteral(Object(literal)), mLine(line), mHash(HashString(lexeme))
     {
     }
 
     Token(TokenType type, const string &lexeme, double literal, int line)
-        : mType(type), mLexeme(lexeme), mLiteral(Object(literal)), mLine(line)
+        : mType(type), mLexeme(lexeme), mLiteral(Object(literal)), mLine(line), mHash(HashString(lexeme))
     {
     }
 
@@ -82,6 +86,11 @@ class Token
     {
         return mLexeme;
     }
+    // the lexeme with its hash, computed once when the token is scanned
+    HashedString Name() const
+    {
+        return HashedString(mLexeme, mHash);
+    }
     const Object &Literal() const
     {
         return mLiteral;
@@ -96,6 +105,7 @@ class Token
     string mLexeme;
     Object mLiteral;
     int mLine;
+    uint32_t mHash;
 }; // namespace lox
 
 std::ostream &operator<<(std::ostream &cout, const Token &token);
@@ -0,0 +1,587 @@
+#include "VM.h"
+#include "Compiler.h"
+#include "Lox.h"
+#include "LoxClass.h"
+#include "LoxList.h"
+#include "LoxMap.h"
+#include "LoxRope.h"
+#include "LoxNative.h"
+
+namespace lox
+{
+
+class VmError : public exception
+{
+  public:
+    VmError(const string &msg) : mMsg(msg)
+    {
+    }
+    virtual const char *what() const throw()
+    {
+        return mMsg.c_str();
+    }
+    const string mMsg;
+};
+
+VM::VM() : VM(std::cout)
+{
+}
+
+VM::VM(std::ostream &os) : VM(os, GcConfig())
+{
+}
+
+VM::VM(std::ostream &os, const GcConfig &gcConfig)
+    : mHeap(gcConfig), mStack(STACK_MAX), mFrames(FRAMES_MAX), mOs(os)
+{
+    mStackTop = mStack.data();
+
+    for (auto &native : Natives())
+        mGlobals.Define(mGlobals.Slot(native.mName),
+                        Value(mHeap.New<LoxNative>(native.mName, native.mArity, native.mFunction)));
+}
+
+void VM::Interpret(const vector<Stmt *> &stmts)
+{
+    Compiler compiler(mGlobals, mHeap);
+    auto script = compiler.Compile(stmts);
+    if (script.IsNil())
+        return;
+
+    auto function = static_cast<VmFunction *>(script.AsObj());
+    if (mDisassembly)
+        function->GetChunk().Disassemble(*mDisassembly, function->Str());
+
+    auto closure = mHeap.New<VmClosure>(function);
+    Push(Value(closure));
+
+    try
+    {
+        Call(closure, 0);
+        Run();
+    }
+    catch (const VmError &error)
+    {
+        // a script needing more stack than there is fails before its own frame exists
+        auto line = closure->Function()->GetChunk().GetLine(0);
+        if (mFrameCount > 0)
+        {
+            auto &frame = mFrames[mFrameCount - 1];
+            auto &chunk = frame.mClosure->Function()->GetChunk();
+            line = chunk.GetLine(frame.mIp - chunk.Code().data() - 1);
+        }
+        Lox::ErrorRuntimeError(line, error.mMsg);
+        ResetStack();
+    }
+}
+
+#define READ_BYTE() (*ip++)
+#define READ_SHORT() (ip += 2, static_cast<uint16_t>((ip[-2] << 8) | ip[-1]))
+#define READ_CONSTANT() (constants[READ_SHORT()])
+#define READ_STRING() (READ_CONSTANT().AsString())
+#define READ_NAME() (static_cast<LoxString *>(READ_CONSTANT().AsObj())->Key())
+#define LOAD_FRAME()                                                                                                   \
+    frame = &mFrames[mFrameCount - 1];                                                                                 \
+    ip = frame->mIp;                                                                                                   \
+    constants = frame->mClosure->Function()->GetChunk().Constants().data();
+#define BINARY_OP(op)                                                                                                  \
+    {                                                                                                                  \
+        if (!Peek(0).IsNumber() || !Peek(1).IsNumber())                                                                \
+            Error("Operands must be numbers.");                                                                        \
+        auto b = Peek(0).AsNumber();                                                                                   \
+        auto a = Peek(1).AsNumber();                                                                                   \
+        mStackTop--;                                                                                                   \
+        mStackTop[-1] = Value(a op b);                                                                                 \
+    }
+
+void VM::Run()
+{
+    CallFrame *frame;
+    uint8_t *ip;
+    const Value *constants;
+    LOAD_FRAME()
+
+    try
+    {
+        for (;;)
+        {
+            switch (READ_BYTE())
+            {
+            case OP_CONSTANT:
+                Push(READ_CONSTANT());
+                break;
+            case OP_NIL:
+                Push(Value());
+                break;
+            case OP_TRUE:
+                Push(Value(true));
+                break;
+            case OP_FALSE:
+                Push(Value(false));
+                break;
+            case OP_POP:
+                Pop();
+                break;
+            case OP_GET_LOCAL:
+                Push(frame->mSlots[READ_BYTE()]);
+                break;
+            case OP_SET_LOCAL:
+                frame->mSlots[READ_BYTE()] = Peek(0);
+                break;
+            case OP_GET_GLOBAL: {
+                auto slot = READ_SHORT();
+                if (!mGlobals.IsDefined(slot))
+                    Error("Undefined variable '" + mGlobals.Name(slot) + "'.");
+                Push(mGlobals.Get(slot));
+                break;
+            }
+            case OP_DEFINE_GLOBAL:
+                mGlobals.Define(READ_SHORT(), Pop());
+                break;
+            case OP_SET_GLOBAL: {
+                auto slot = READ_SHORT();
+                if (!mGlobals.IsDefined(slot))
+                    Error("Undefined variable '" + mGlobals.Name(slot) + "'.");
+                mGlobals.Set(slot, Peek(0));
+                break;
+            }
+            case OP_GET_UPVALUE:
+                Push(*frame->mClosure->Upvalue(READ_BYTE())->Location());
+                break;
+            case OP_SET_UPVALUE:
+                *frame->mClosure->Upvalue(READ_BYTE())->Location() = Peek(0);
+                break;
+            case OP_GET_PROPERTY: {
+                if (!Peek(0).IsInstance())
+                    Error("Only instances have properties.");
+
+                auto &instance = Peek(0).AsInstance();
+                auto name = READ_NAME();
+                Value value;
+                if (instance.GetField(name, value))
+                {
+                    mStackTop[-1] = std::move(value);
+                    break;
+                }
+                BindMethod(instance.Klass(), name);
+                break;
+            }
+            case OP_SET_PROPERTY: {
+                if (!Peek(1).IsInstance())
+                    Error("Only instances have fields.");
+
+                Peek(1).AsInstance().SetField(READ_NAME(), Peek(0));
+                auto value = Pop();
+                mStackTop[-1] = std::move(value);
+                break;
+            }
+            case OP_GET_SUPER: {
+                auto name = READ_NAME();
+                auto superclass = Pop();
+                BindMethod(superclass.AsClass(), name);
+                break;
+            }
+            case OP_BUILD_LIST: {
+                auto count = READ_SHORT();
+                auto list = New<LoxList>(mStackTop - count, count);
+                mStackTop -= count;
+                Push(Value(list));
+                break;
+            }
+            case OP_BUILD_MAP: {
+                auto count = READ_SHORT();
+                auto map = New<LoxMap>();
+                // the entries stay on the stack, and so reachable, until the map holds them
+                for (auto entry = mStackTop - 2 * count; entry < mStackTop; entry += 2)
+                {
+                    entry[0] = LoxRope::Flatten(mHeap, entry[0]);
+                    if (auto error = LoxMap::CheckKey(entry[0]))
+                        Error(error);
+                    map->Set(mHeap, entry[0], entry[1]);
+                }
+                mStackTop -= 2 * count;
+                Push(Value(map));
+                break;
+            }
+            case OP_GET_INDEX: {
+                if (Peek(1).IsMap())
+                {
+                    mStackTop[-1] = LoxRope::Flatten(mHeap, Peek(0));
+                    if (auto error = LoxMap::CheckKey(Peek(0)))
+                        Error(error);
+                    Value value;
+                    Peek(1).AsMap().Get(Peek(0), value);
+                    Pop();
+                    mStackTop[-1] = value;
+                    break;
+                }
+                if (!Peek(1).IsList())
+                    Error("Only lists and maps can be indexed.");
+
+                auto &list = Peek(1).AsList();
+                size_t position;
+                if (auto error = list.CheckIndex(Peek(0), position))
+                    Error(error);
+                Pop();
+                mStackTop[-1] = list.At(position);
+                break;
+            }
+            case OP_SET_INDEX: {
+                if (Peek(2).IsMap())
+                {
+                    mStackTop[-2] = LoxRope::Flatten(mHeap, Peek(1));
+                    if (auto error = LoxMap::CheckKey(Peek(1)))
+                        Error(error);
+                    Peek(2).AsMap().Set(mHeap, Peek(1), Peek(0));
+                    auto value = Pop();
+                    Pop();
+                    mStackTop[-1] = value;
+                    // the map may have grown its table
+                    if (mHeap.ShouldCollect())
+                        CollectGarbage();
+                    break;
+                }
+                if (!Peek(2).IsList())
+                    Error("Only lists and maps can be indexed.");
+
+                auto &list = Peek(2).AsList();
+                size_t position;
+                if (auto error = list.CheckIndex(Peek(1), position))
+                    Error(error);
+                list.At(position) = Peek(0);
+                auto value = Pop();
+                Pop();
+                mStackTop[-1] = value;
+                break;
+            }
+            case OP_EQUAL: {
+                auto equal = LoxRope::Flatten(mHeap, Peek(1)).Equals(LoxRope::Flatten(mHeap, Peek(0)));
+                Pop();
+                mStackTop[-1] = Value(equal);
+                break;
+            }
+            case OP_GREATER:
+                BINARY_OP(>)
+                break;
+            case OP_GREATER_EQUAL:
+                BINARY_OP(>=)
+                break;
+            case OP_LESS:
+                BINARY_OP(<)
+                break;
+            case OP_LESS_EQUAL:
+                BINARY_OP(<=)
+                break;
+            case OP_ADD: {
+                if (Peek(0).IsNumber() && Peek(1).IsNumber())
+                {
+                    BINARY_OP(+)
+                }
+                else if (LoxRope::IsText(Peek(0)) && LoxRope::IsText(Peek(1)))
+                {
+                    // a short result cannot have a rope operand
+                    Value result;
+                    if (LoxRope::Length(Peek(1)) + LoxRope::Length(Peek(0)) < LoxRope::MIN_LENGTH)
+                        result = Value(Intern(Peek(1).AsString() + Peek(0).AsString()));
+                    else
+                        result = Value(New<LoxRope>(Peek(1), Peek(0)));
+                    Pop();
+                    mStackTop[-1] = result;
+                }
+                else
+                {
+                    Error("Operands must be two numbers or two strings.");
+                }
+                break;
+            }
+            case OP_SUBTRACT:
+                BINARY_OP(-)
+                break;
+            case OP_MULTIPLY:
+                BINARY_OP(*)
+                break;
+            case OP_DIVIDE:
+                BINARY_OP(/)
+                break;
+            case OP_NOT: {
+                auto &value = Peek(0);
+                auto falsey = value.IsNil() || (value.IsBoolean() && !value.AsBoolean());
+                mStackTop[-1] = Value(falsey);
+                break;
+            }
+            case OP_NEGATE:
+                if (!Peek(0).IsNumber())
+                    Error("Operand must be a number.");
+                mStackTop[-1] = Value(-Peek(0).AsNumber());
+                break;
+            case OP_PRINT:
+                mOs << Pop().Str() << std::endl;
+                break;
+            case OP_JUMP: {
+                auto offset = READ_SHORT();
+                ip += offset;
+                break;
+            }
+            case OP_JUMP_IF_FALSE: {
+                auto offset = READ_SHORT();
+                auto &value = Peek(0);
+                if (value.IsNil() || (value.IsBoolean() && !value.AsBoolean()))
+                    ip += offset;
+                break;
+            }
+            case OP_LOOP: {
+                auto offset = READ_SHORT();
+                ip -= offset;
+                break;
+            }
+            case OP_CALL: {
+                int argCount = READ_BYTE();
+                frame->mIp = ip;
+                CallValue(Peek(argCount), argCount);
+                LOAD_FRAME()
+                break;
+            }
+            case OP_INVOKE: {
+                auto name = READ_NAME();
+                int argCount = READ_BYTE();
+                frame->mIp = ip;
+                Invoke(name, argCount);
+                LOAD_FRAME()
+                break;
+            }
+            case OP_SUPER_INVOKE: {
+                auto name = READ_NAME();
+                int argCount = READ_BYTE();
+                auto superclass = Pop();
+                frame->mIp = ip;
+                InvokeFromClass(superclass.AsClass(), name, argCount);
+                LOAD_FRAME()
+                break;
+            }
+            case OP_CLOSURE: {
+                auto function = static_cast<VmFunction *>(READ_CONSTANT().AsObj());
+                auto closure = New<VmClosure>(function);
+                Push(Value(closure));
+                for (int i = 0; i < function->UpvalueCount(); i++)
+                {
+                    auto isLocal = READ_BYTE();
+                    auto index = READ_BYTE();
+                    closure->SetUpvalue(i, isLocal ? CaptureUpvalue(frame->mSlots + index)
+                                                   : frame->mClosure->Upvalue(index));
+                }
+                break;
+            }
+            case OP_CLOSE_UPVALUE:
+                CloseUpvalues(mStackTop - 1);
+                Pop();
+                break;
+            case OP_RETURN: {
+                auto result = Pop();
+                CloseUpvalues(frame->mSlots);
+                mFrameCount--;
+                mStackTop = frame->mSlots;
+                if (mFrameCount == 0)
+                    return;
+
+                Push(result);
+                LOAD_FRAME()
+                break;
+            }
+            case OP_CLASS:
+                Push(Value(New<LoxClass>(READ_STRING(), nullptr, StringMap<Value>())));
+                break;
+            case OP_INHERIT: {
+                if (!Peek(1).IsClass())
+                    Error("Superclass must be a class.");
+                Peek(0).AsClass().Inherit(&Peek(1).AsClass());
+                Pop();
+                break;
+            }
+            case OP_METHOD:
+                Peek(1).AsClass().AddMethod(READ_STRING(), Peek(0));
+                Pop();
+                break;
+            }
+        }
+    }
+    catch (const VmError &)
+    {
+        // remember where the error happened for the line report
+        frame->mIp = ip;
+        throw;
+    }
+}
+
+#undef READ_BYTE
+#undef READ_SHORT
+#undef READ_CONSTANT
+#undef READ_STRING
+#undef READ_NAME
+#undef LOAD_FRAME
+#undef BINARY_OP
+
+void VM::CollectGarbage()
+{
+    mHeap.Collect([this](Heap &heap) {
+        for (auto slot = mStack.data(); slot < mStackTop; slot++)
+            heap.Mark(*slot);
+        for (int i = 0; i < mFrameCount; i++)
+            heap.Mark(mFrames[i].mClosure);
+        for (auto upvalue = mOpenUpvalues; upvalue; upvalue = upvalue->Next())
+            heap.Mark(upvalue);
+        mGlobals.Trace(heap);
+    });
+}
+
+void VM::CallValue(const Value &callee, int argCount)
+{
+    if (callee.IsObj())
+    {
+        switch (callee.AsObj()->Kind())
+        {
+        case OBJ_KIND_CLOSURE:
+            Call(static_cast<VmClosure *>(callee.AsObj()), argCount);
+            return;
+        case OBJ_KIND_BOUND_METHOD: {
+            // callee lives in the slot the receiver is written to
+            auto method = static_cast<VmBoundMethod *>(callee.AsObj());
+            mStackTop[-argCount - 1] = method->Receiver();
+            Call(method->Method(), argCount);
+            return;
+        }
+        case OBJ_KIND_CLASS: {
+            auto &klass = callee.AsClass();
+            auto initializer = klass.Initializer();
+            mStackTop[-argCount - 1] = Value(New<LoxInstance>(&klass));
+            if (initializer)
+                Call(static_cast<VmClosure *>(initializer->AsObj()), argCount);
+            else if (argCount != 0)
+                Error("Expected 0 arguments but got " + std::to_string(argCount) + ".");
+            return;
+        }
+        case OBJ_KIND_NATIVE: {
+            // natives read their arguments in place and the result replaces the callee
+            auto native = static_cast<LoxNative *>(callee.AsObj());
+            if (static_cast<size_t>(argCount) != native->Arity())
+                Error("Expected " + std::to_string(native->Arity()) + " arguments but got " +
+                      std::to_string(argCount) + ".");
+
+            Value result;
+            try
+            {
+                result = native->Invoke(mHeap, mStackTop - argCount);
+            }
+            catch (const NativeError &error)
+            {
+                Error(error.mMsg);
+            }
+            mStackTop -= argCount;
+            mStackTop[-1] = result;
+            // a native may have grown a list or a map past the threshold, and everything is rooted again here
+            if (mHeap.ShouldCollect())
+                CollectGarbage();
+            return;
+        }
+        default:
+            break;
+        }
+    }
+    Error("Can only call functions and classes.");
+}
+
+void VM::Call(VmClosure *closure, int argCount)
+{
+    auto arity = closure->Function()->Arity();
+    if (argCount != arity)
+        Error("Expected " + std::to_string(arity) + " arguments but got " + std::to_string(argCount) + ".");
+    // the frame starts at the callee, and its code never pushes past the height the compiler computed
+    auto slots = mStackTop - argCount - 1;
+    if (mFrameCount == FRAMES_MAX || slots + closure->Function()->MaxStackHeight() > mStack.data() + STACK_MAX)
+        Error("Stack overflow.");
+
+    auto &frame = mFrames[mFrameCount++];
+    frame.mClosure = closure;
+    frame.mIp = closure->Function()->GetChunk().Code().data();
+    frame.mSlots = slots;
+}
+
+void VM::Invoke(const HashedString &name, int argCount)
+{
+    auto &receiver = Peek(argCount);
+    if (!receiver.IsInstance())
+        Error("Only instances have properties.");
+
+    auto &instance = receiver.AsInstance();
+    Value field;
+    if (instance.GetField(name, field))
+    {
+        mStackTop[-argCount - 1] = field;
+        CallValue(field, argCount);
+        return;
+    }
+    InvokeFromClass(instance.Klass(), name, argCount);
+}
+
+void VM::InvokeFromClass(const LoxClass &klass, const HashedString &name, int argCount)
+{
+    auto method = klass.FindMethodValue(name);
+    if (!method)
+        Error("Undefined property '" + string(name.mString) + "'.");
+    Call(static_cast<VmClosure *>(method->AsObj()), argCount);
+}
+
+void VM::BindMethod(const LoxClass &klass, const HashedString &name)
+{
+    auto method = klass.FindMethodValue(name);
+    if (!method)
+        Error("Undefined property '" + string(name.mString) + "'.");
+
+    auto bound = New<VmBoundMethod>(Peek(0), static_cast<VmClosure *>(method->AsObj()));
+    mStackTop[-1] = Value(bound);
+}
+
+VmUpvalue *VM::CaptureUpvalue(Value *local)
+{
+    // open upvalues are kept sorted by stack slot, top most first
+    VmUpvalue *prev = nullptr;
+    auto upvalue = mOpenUpvalues;
+    while (upvalue && upvalue->Location() > local)
+    {
+        prev = upvalue;
+        upvalue = upvalue->Next();
+    }
+    if (upvalue && upvalue->Location() == local)
+        return upvalue;
+
+    auto created = New<VmUpvalue>(local);
+    created->SetNext(upvalue);
+    if (prev)
+        prev->SetNext(created);
+    else
+        mOpenUpvalues = created;
+    return created;
+}
+
+void VM::CloseUpvalues(Value *last)
+{
+    while (mOpenUpvalues && mOpenUpvalues->Location() >= last)
+    {
+        auto upvalue = mOpenUpvalues;
+        upvalue->Close();
+        mOpenUpvalues = upvalue->Next();
+    }
+}
+
+void VM::ResetStack()
+{
+    CloseUpvalues(mStack.data());
+    mStackTop = mStack.data();
+    mFrameCount = 0;
+}
+
+void VM::Error(const string &message) const
+{
+    throw VmError(message);
+}
+
+} // namespace lox
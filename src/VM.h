@@ -0,0 +1,112 @@
+#pragma once
+
+#include "Chunk.h"
+#include "GlobalTable.h"
+#include "Heap.h"
+#include "Stmt.h"
+#include "VmObject.h"
+#include <iostream>
+#include <vector>
+
+namespace lox
+{
+
+using std::vector;
+
+class LoxClass;
+
+struct CallFrame
+{
+    VmClosure *mClosure;
+    uint8_t *mIp;
+    Value *mSlots;
+};
+
+// Stack based virtual machine executing the bytecode produced by Compiler.
+// An alternative to the tree-walking Interpreter, selected with `lox --engine=vm`.
+class VM
+{
+  public:
+    VM();
+    VM(std::ostream &os);
+    VM(std::ostream &os, const GcConfig &gcConfig);
+
+    void Interpret(const vector<Stmt *> &stmts);
+
+    // when set, the bytecode of every script is listed to os before it runs
+    void SetDisassembly(std::ostream *os)
+    {
+        mDisassembly = os;
+    }
+
+    const Heap &GetHeap() const
+    {
+        return mHeap;
+    }
+
+    // for test
+    const GlobalTable &Globals() const
+    {
+        return mGlobals;
+    }
+
+  private:
+    static constexpr int FRAMES_MAX = 1024;
+    static constexpr int STACK_MAX = FRAMES_MAX * 256;
+
+    void Run();
+
+    void Push(const Value &value)
+    {
+        *mStackTop++ = value;
+    }
+    Value Pop()
+    {
+        return std::move(*--mStackTop);
+    }
+    const Value &Peek(int distance) const
+    {
+        return mStackTop[-1 - distance];
+    }
+
+    // allocation is where the VM collects, everything live is reachable from the stack by then
+    template <typename T, typename... Args> T *New(Args &&...args)
+    {
+        if (mHeap.ShouldCollect())
+            CollectGarbage();
+        return mHeap.New<T>(std::forward<Args>(args)...);
+    }
+    LoxString *Intern(string &&str)
+    {
+        if (mHeap.ShouldCollect())
+            CollectGarbage();
+        return mHeap.Intern(std::move(str));
+    }
+    void CollectGarbage();
+
+    void CallValue(const Value &callee, int argCount);
+    void Call(VmClosure *closure, int argCount);
+    void Invoke(const HashedString &name, int argCount);
+    void InvokeFromClass(const LoxClass &klass, const HashedString &name, int argCount);
+    void BindMethod(const LoxClass &klass, const HashedString &name);
+    VmUpvalue *CaptureUpvalue(Value *local);
+    void CloseUpvalues(Value *last);
+
+    void ResetStack();
+    [[noreturn]] void Error(const string &message) const;
+
+    Heap mHeap;
+
+    vector<Value> mStack;
+    Value *mStackTop;
+    vector<CallFrame> mFrames;
+    int mFrameCount = 0;
+    VmUpvalue *mOpenUpvalues = nullptr;
+
+    GlobalTable mGlobals;
+
+    std::ostream &mOs;
+    std::ostream *mDisassembly = nullptr;
+};
+
+} // namespace lox
@@ -0,0 +1,68 @@
+#include "Value.h"
+#include "LoxClass.h"
+#include "LoxFunction.h"
+#include "LoxList.h"
+#include "LoxMap.h"
+#include "LoxRope.h"
+#include "LoxNative.h"
+
+namespace lox
+{
+
+LoxCallable *Value::AsCallable() const
+{
+    if (!IsCallable())
+        UNSUPPOSED_OPERATION_ERROR("AsCallable")
+    return static_cast<LoxCallable *>(AsObj());
+}
+
+LoxFunction &Value::AsFunction() const
+{
+    if (!IsFunction())
+        UNSUPPOSED_OPERATION_ERROR("AsFunction")
+    return *static_cast<LoxFunction *>(AsObj());
+}
+
+LoxClass &Value::AsClass() const
+{
+    if (!IsClass())
+        UNSUPPOSED_OPERATION_ERROR("AsClass")
+    return *static_cast<LoxClass *>(AsObj());
+}
+
+LoxInstance &Value::AsInstance() const
+{
+    if (!IsInstance())
+        UNSUPPOSED_OPERATION_ERROR("AsInstance")
+    return *static_cast<LoxInstance *>(AsObj());
+}
+
+LoxNative &Value::AsNative() const
+{
+    if (!IsNative())
+        UNSUPPOSED_OPERATION_ERROR("AsNative")
+    return *static_cast<LoxNative *>(AsObj());
+}
+
+LoxList &Value::AsList() const
+{
+    if (!IsList())
+        UNSUPPOSED_OPERATION_ERROR("AsList")
+    return *static_cast<LoxList *>(AsObj());
+}
+
+LoxMap &Value::AsMap() const
+{
+    if (!IsMap())
+        UNSUPPOSED_OPERATION_ERROR("AsMap")
+    return *static_cast<LoxMap *>(AsObj());
+}
+
+LoxRope &Value::AsRope() const
+{
+    if (!IsRope())
+        UNSUPPOSED_OPERATION_ERROR("AsRope")
+    return *static_cast<LoxRope *>(AsObj());
+}
+
+} // namespace lox
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <cstdint>
+#include <cstring>
 #include <iomanip>
-#include <memory>
+#include <sstream>
 #include <string>
+#include <type_traits>
+
+#include "StringHash.h"
 
 #define UNSUPPOSED_OPERATION_ERROR(op) throw(UnsupposedValueOperationError("Unsupposed call: " + string(op)));
 
@@ -10,13 +15,17 @@ namespace lox
 {
 
 using std::exception;
-using std::shared_ptr;
 using std::string;
 
 class LoxCallable;
 class LoxFunction;
 class LoxClass;
 class LoxInstance;
+class LoxNative;
+class LoxList;
+class LoxMap;
+class LoxRope;
+class Heap;
 
 class UnsupposedValueOperationError : public exception
 {
@@ -31,162 +40,260 @@ class UnsupposedValueOperationError : public exception
     const string mMsg;
 };
 
-class Value
+// LoxCallable kinds are kept last so that IsCallable is a range check
+enum ObjKind : uint8_t
+{
+    OBJ_KIND_STRING,
+    OBJ_KIND_ROPE,
+    OBJ_KIND_INSTANCE,
+    OBJ_KIND_LIST,
+    OBJ_KIND_MAP,
+    OBJ_KIND_CELL,
+    /* bytecode VM */
+    OBJ_KIND_VM_FUNCTION,
+    OBJ_KIND_UPVALUE,
+    OBJ_KIND_CLOSURE,
+    OBJ_KIND_BOUND_METHOD,
+    /* LoxCallable */
+    OBJ_KIND_FUNCTION,
+    OBJ_KIND_CLASS,
+    OBJ_KIND_NATIVE,
+};
+
+// Base of every heap allocated runtime object.
+// Objects are owned by the Heap they were allocated from, which links them into its object list.
+class Obj
 {
+    friend class Heap;
+
   public:
-    virtual const string &AsString() const
+    Obj(ObjKind kind) : mKind(kind)
     {
-        UNSUPPOSED_OPERATION_ERROR("AsString")
     }
-    virtual const double AsNumber() const
+    Obj(const Obj &) = delete;
+    Obj &operator=(const Obj &) = delete;
+    virtual ~Obj()
     {
-        UNSUPPOSED_OPERATION_ERROR("AsNumber")
     }
-    virtual const bool AsBoolean() const
+
+    ObjKind Kind() const
     {
-        UNSUPPOSED_OPERATION_ERROR("AsBoolean")
+        return mKind;
     }
-    virtual LoxCallable *AsCallable()
+    bool IsCallable() const
     {
-        UNSUPPOSED_OPERATION_ERROR("AsCallable")
+        return mKind >= OBJ_KIND_FUNCTION;
     }
-    virtual LoxFunction &AsFunction()
+
+    // marks the objects directly referenced by this one
+    virtual void Trace(Heap &heap) const
     {
-        UNSUPPOSED_OPERATION_ERROR("AsFunction")
     }
-    virtual LoxClass &AsClass()
+
+    virtual const string Str() const = 0;
+
+  protected:
+    // set while Str of a container runs, so one reached again through its own elements prints as a cycle
+    mutable bool mPrinting = false;
+
+  private:
+    const ObjKind mKind;
+    bool mMarked = false;
+    uint32_t mSize = 0;
+    Obj *mNext = nullptr;
+};
+
+// Immutable string with its hash computed once.
+// Strings are only created through Heap::Intern, so two equal strings of one heap are the same object.
+class LoxString : public Obj
+{
+    friend class Heap;
+
+  public:
+    const string &AsString() const
     {
-        UNSUPPOSED_OPERATION_ERROR("AsClass")
+        return mValue;
     }
-    virtual LoxInstance &AsInstance()
+    uint32_t Hash() const
     {
-        UNSUPPOSED_OPERATION_ERROR("AsInstance")
+        return mHash;
     }
-
-    virtual const bool IsString() const
+    HashedString Key() const
     {
-        return false;
+        return HashedString{mValue, mHash};
     }
-    virtual const bool IsNumber() const
+
+    virtual const string Str() const override
     {
-        return false;
+        return mValue;
     }
-    virtual const bool IsBoolean() const
+
+  private:
+    LoxString(string &&value, uint32_t hash) : Obj(OBJ_KIND_STRING), mValue(std::move(value)), mHash(hash)
     {
-        return false;
     }
-    virtual const bool IsCallable() const
+
+    string mValue;
+    uint32_t mHash;
+};
+
+// 8 byte NaN-boxed value.
+// Numbers are stored as plain doubles. nil, booleans and object pointers live in the payload of a quiet NaN, so
+// only objects ever touch the heap. Values do not own objects, the Heap does.
+class Value
+{
+    static constexpr uint64_t SIGN_BIT = 0x8000000000000000;
+    static constexpr uint64_t QNAN = 0x7ffc000000000000;
+    static constexpr uint64_t OBJ_MASK = SIGN_BIT | QNAN;
+
+    static constexpr uint64_t NIL_BITS = QNAN | 1;
+    static constexpr uint64_t FALSE_BITS = QNAN | 2;
+    static constexpr uint64_t TRUE_BITS = QNAN | 3;
+    // the one NaN numbers are stored as, it is outside of the tagged range
+    static constexpr uint64_t CANONICAL_NAN = 0x7ff8000000000000;
+
+  public:
+    Value() : mBits(NIL_BITS)
     {
-        return false;
     }
-    virtual const bool IsFunction() const
+    // a NaN may carry any payload, which could be mistaken for a tag, so all of them are stored as one
+    explicit Value(double number)
     {
-        return false;
+        if (number != number)
+            mBits = CANONICAL_NAN;
+        else
+            std::memcpy(&mBits, &number, sizeof(double));
     }
-    virtual const bool IsClass() const
+    explicit Value(bool boolean) : mBits(boolean ? TRUE_BITS : FALSE_BITS)
     {
-        return false;
     }
-    virtual const bool IsInstance() const
+    explicit Value(Obj *obj) : mBits(OBJ_MASK | reinterpret_cast<uintptr_t>(obj))
     {
-        return false;
     }
 
-    virtual const bool Equals(const Value &other) const = 0;
-
-    virtual const string Str() const = 0;
-};
-
-class StringValue : public Value
-{
-  public:
-    StringValue(const string &value) : mValue(value)
+    bool IsNil() const
     {
+        return mBits == NIL_BITS;
     }
-    const string &AsString() const override
+    bool IsNumber() const
     {
-        return mValue;
+        return (mBits & QNAN) != QNAN;
     }
-
-    virtual const bool IsString() const override
+    bool IsBoolean() const
     {
-        return true;
+        return (mBits | 1) == TRUE_BITS;
     }
-
-    virtual const bool Equals(const Value &other) const override
+    bool IsObj() const
     {
-        return other.IsString() && mValue == other.AsString();
+        return (mBits & OBJ_MASK) == OBJ_MASK;
     }
-
-    virtual const string Str() const override
+    bool IsString() const
     {
-        return mValue;
+        return IsObjOf(OBJ_KIND_STRING);
     }
-
-  private:
-    string mValue;
-};
-
-class NumberValue : public Value
-{
-  public:
-    NumberValue(const double &value) : mValue(value)
+    bool IsRope() const
     {
+        return IsObjOf(OBJ_KIND_ROPE);
     }
-    const double AsNumber() const override
+    bool IsCallable() const
     {
-        return mValue;
+        return IsObj() && AsObj()->IsCallable();
     }
-
-    virtual const bool IsNumber() const override
+    bool IsFunction() const
     {
-        return true;
+        return IsObjOf(OBJ_KIND_FUNCTION);
     }
-
-    virtual const bool Equals(const Value &other) const override
+    bool IsClass() const
     {
-        return other.IsNumber() && mValue == other.AsNumber();
+        return IsObjOf(OBJ_KIND_CLASS);
     }
-
-    virtual const string Str() const override
+    bool IsInstance() const
     {
-        std::ostringstream oss;
-        oss << std::noshowpoint << mValue;
-        return oss.str();
+        return IsObjOf(OBJ_KIND_INSTANCE);
+    }
+    bool IsNative() const
+    {
+        return IsObjOf(OBJ_KIND_NATIVE);
+    }
+    bool IsList() const
+    {
+        return IsObjOf(OBJ_KIND_LIST);
+    }
+    bool IsMap() const
+    {
+        return IsObjOf(OBJ_KIND_MAP);
     }
 
-  private:
-    double mValue;
-};
+    double AsNumber() const
+    {
+        if (!IsNumber())
+            UNSUPPOSED_OPERATION_ERROR("AsNumber")
 
-class BooleanValue : public Value
-{
-  public:
-    BooleanValue(const bool &value) : mValue(value)
+        double number;
+        std::memcpy(&number, &mBits, sizeof(double));
+        return number;
+    }
+    bool AsBoolean() const
     {
+        if (!IsBoolean())
+            UNSUPPOSED_OPERATION_ERROR("AsBoolean")
+        return mBits == TRUE_BITS;
     }
-    const bool AsBoolean() const override
+    Obj *AsObj() const
     {
-        return mValue;
+        return reinterpret_cast<Obj *>(mBits & ~OBJ_MASK);
     }
-
-    virtual const bool IsBoolean() const override
+    const string &AsString() const
     {
-        return true;
+        if (!IsString())
+            UNSUPPOSED_OPERATION_ERROR("AsString")
+        return static_cast<LoxString *>(AsObj())->AsString();
     }
+    LoxCallable *AsCallable() const;
+    LoxFunction &AsFunction() const;
+    LoxClass &AsClass() const;
+    LoxInstance &AsInstance() const;
+    LoxNative &AsNative() const;
+    LoxList &AsList() const;
+    LoxMap &AsMap() const;
+    LoxRope &AsRope() const;
 
-    virtual const bool Equals(const Value &other) const override
+    // numbers compare by value, everything else by identity, which for interned strings is the same thing.
+    // The engines flatten ropes before comparing them, comparing their characters here is only a fallback.
+    bool Equals(const Value &other) const
     {
-        return other.IsBoolean() && mValue == other.AsBoolean();
+        if (IsNumber() && other.IsNumber())
+            return AsNumber() == other.AsNumber();
+        if (IsRope() || other.IsRope())
+            return (IsString() || IsRope()) && (other.IsString() || other.IsRope()) && Str() == other.Str();
+        return mBits == other.mBits;
     }
 
-    virtual const string Str() const override
+    const string Str() const
     {
-        return mValue ? "true" : "false";
+        if (IsNumber())
+        {
+            std::ostringstream oss;
+            oss << std::noshowpoint << AsNumber();
+            return oss.str();
+        }
+        if (IsBoolean())
+            return AsBoolean() ? "true" : "false";
+        if (IsNil())
+            return "nil";
+        return AsObj()->Str();
     }
 
   private:
-    bool mValue;
+    bool IsObjOf(ObjKind kind) const
+    {
+        return IsObj() && AsObj()->Kind() == kind;
+    }
+
+    uint64_t mBits;
 };
 
+static_assert(sizeof(Value) == 8, "Value must stay NaN-boxed");
+static_assert(std::is_trivially_copyable_v<Value>);
+
 } // namespace lox
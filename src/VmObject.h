@@ -0,0 +1,190 @@
+#pragma once
+
+#include "Chunk.h"
+#include "Heap.h"
+#include "Value.h"
+#include <vector>
+
+namespace lox
+{
+
+using std::vector;
+
+// Compiled body of a function. Only ever reached through a VmClosure at runtime.
+class VmFunction : public Obj
+{
+  public:
+    VmFunction(const string &name) : Obj(OBJ_KIND_VM_FUNCTION), mName(name)
+    {
+    }
+
+    Chunk &GetChunk()
+    {
+        return mChunk;
+    }
+    const string &Name() const
+    {
+        return mName;
+    }
+    int Arity() const
+    {
+        return mArity;
+    }
+    void SetArity(int arity)
+    {
+        mArity = arity;
+    }
+    int UpvalueCount() const
+    {
+        return mUpvalueCount;
+    }
+    void SetUpvalueCount(int upvalueCount)
+    {
+        mUpvalueCount = upvalueCount;
+    }
+    // stack slots a call needs, the callee, the arguments, the locals and the temporaries included
+    int MaxStackHeight() const
+    {
+        return mMaxStackHeight;
+    }
+    void SetMaxStackHeight(int height)
+    {
+        mMaxStackHeight = height;
+    }
+
+    virtual void Trace(Heap &heap) const override
+    {
+        for (auto &constant : mChunk.Constants())
+            heap.Mark(constant);
+    }
+
+    virtual const string Str() const override
+    {
+        return mName.empty() ? "<script>" : "<fn " + mName + ">";
+    }
+
+  private:
+    string mName;
+    int mArity = 0;
+    int mUpvalueCount = 0;
+    int mMaxStackHeight = 0;
+    Chunk mChunk;
+};
+
+// A variable captured by a closure. While open it points at the variable's stack slot,
+// once the slot goes out of scope the value is moved into mClosed.
+class VmUpvalue : public Obj
+{
+  public:
+    VmUpvalue(Value *slot) : Obj(OBJ_KIND_UPVALUE), mLocation(slot)
+    {
+    }
+
+    Value *Location() const
+    {
+        return mLocation;
+    }
+    VmUpvalue *Next() const
+    {
+        return mNext;
+    }
+    void SetNext(VmUpvalue *next)
+    {
+        mNext = next;
+    }
+    void Close()
+    {
+        mClosed = *mLocation;
+        mLocation = &mClosed;
+    }
+
+    virtual void Trace(Heap &heap) const override
+    {
+        heap.Mark(mClosed);
+    }
+
+    virtual const string Str() const override
+    {
+        return "upvalue";
+    }
+
+  private:
+    Value *mLocation;
+    Value mClosed;
+    VmUpvalue *mNext = nullptr;
+};
+
+class VmClosure : public Obj
+{
+  public:
+    VmClosure(VmFunction *function)
+        : Obj(OBJ_KIND_CLOSURE), mFunction(function), mUpvalues(function->UpvalueCount(), nullptr)
+    {
+    }
+
+    VmFunction *Function() const
+    {
+        return mFunction;
+    }
+    VmUpvalue *Upvalue(int index) const
+    {
+        return mUpvalues[index];
+    }
+    void SetUpvalue(int index, VmUpvalue *upvalue)
+    {
+        mUpvalues[index] = upvalue;
+    }
+
+    // upvalues are still null while the closure is being created
+    virtual void Trace(Heap &heap) const override
+    {
+        heap.Mark(mFunction);
+        for (auto upvalue : mUpvalues)
+            heap.Mark(upvalue);
+    }
+
+    virtual const string Str() const override
+    {
+        return mFunction->Str();
+    }
+
+  private:
+    VmFunction *mFunction;
+    vector<VmUpvalue *> mUpvalues;
+};
+
+// A method closure paired with the instance it was accessed on.
+class VmBoundMethod : public Obj
+{
+  public:
+    VmBoundMethod(const Value &receiver, VmClosure *method)
+        : Obj(OBJ_KIND_BOUND_METHOD), mReceiver(receiver), mMethod(method)
+    {
+    }
+
+    const Value &Receiver() const
+    {
+        return mReceiver;
+    }
+    VmClosure *Method() const
+    {
+        return mMethod;
+    }
+
+    virtual void Trace(Heap &heap) const override
+    {
+        heap.Mark(mReceiver);
+        heap.Mark(mMethod);
+    }
+
+    virtual const string Str() const override
+    {
+        return mMethod->Str();
+    }
+
+  private:
+    Value mReceiver;
+    VmClosure *mMethod;
+};
+
+} // namespace lox
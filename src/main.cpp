@@ -6,17 +6,78 @@
 
 using namespace lox;
 
+static bool ParseOption(const string &arg, const string &name, string &value)
+{
+    if (!arg.starts_with(name + "="))
+        return false;
+    value = arg.substr(name.size() + 1);
+    return true;
+}
+
 int main(int argc, char const *argv[])
 {
-    if (argc == 1)
+    // usage: lox [--engine=tree|vm] [--gc-threshold=bytes] [--gc-growth=factor] [--gc-stress] [--gc-stats]
+    //            [--shape-stats] [--disassemble] [script]
+    auto engine = ENGINE_TREE_WALKER;
+    GcConfig gcConfig;
+    bool printGcStats = false;
+    bool printShapeStats = false;
+    bool disassemble = false;
+
+    int argi = 1;
+    for (; argi < argc && string(argv[argi]).starts_with("--"); argi++)
+    {
+        string arg(argv[argi]);
+        string value;
+        if (ParseOption(arg, "--engine", value) && (value == "vm" || value == "tree"))
+            engine = value == "vm" ? ENGINE_VM : ENGINE_TREE_WALKER;
+        else if (ParseOption(arg, "--gc-threshold", value))
+            gcConfig.mInitialThreshold = std::stoul(value);
+        else if (ParseOption(arg, "--gc-growth", value))
+            gcConfig.mGrowthFactor = std::stod(value);
+        else if (arg == "--gc-stress")
+            gcConfig.mStress = true;
+        else if (arg == "--gc-stats")
+            printGcStats = true;
+        else if (arg == "--shape-stats")
+            printShapeStats = true;
+        else if (arg == "--disassemble")
+            disassemble = true;
+        else
+        {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 64;
+        }
+    }
+    Lox::SetGcConfig(gcConfig);
+    Lox::SetDisassemble(disassemble);
+
+    if (argi == argc)
     {
         std::cout << "lox 0.0.0d" << std::endl;
         std::cout << "------------" << std::endl;
-        Lox::RunRepl();
+        Lox::RunRepl(engine);
     }
-    else if (argc >= 2)
+    else
+    {
+        Lox::RunFile(string(argv[argi]), engine);
+    }
+
+    if (printGcStats)
+    {
+        auto &stats = Lox::LastGcStats();
+        std::cerr << "gc collections: " << stats.mCollections << std::endl;
+        std::cerr << "gc objects allocated: " << stats.mObjectsAllocated << ", freed: " << stats.mObjectsFreed
+                  << std::endl;
+        std::cerr << "gc bytes allocated: " << stats.mBytesAllocated << ", freed: " << stats.mBytesFreed
+                  << ", peak: " << stats.mPeakBytes << std::endl;
+    }
+
+    if (printShapeStats)
     {
-        Lox::RunFile(string(argv[1]));
+        auto &stats = Shape::Stats();
+        std::cerr << "shapes: " << stats.mShapes << ", transitions: " << stats.mTransitions
+                  << ", megamorphic sites: " << stats.mMegamorphicSites << std::endl;
     }
 
     return 0;
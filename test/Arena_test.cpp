@@ -0,0 +1,64 @@
+#include "Arena.h"
+#include "TestUtil.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using namespace lox;
+using namespace std;
+
+class ArenaTestFixture : public CcloxTestFixtureBase
+{
+  public:
+    ArenaTestFixture()
+    {
+    }
+    void SetUp()
+    {
+    }
+    void TearDown()
+    {
+    }
+};
+
+TEST_F(ArenaTestFixture, Allocate)
+{
+    Arena arena;
+    auto c = arena.New<char>('a');
+    auto d = arena.New<double>(1.5);
+    ASSERT_EQ('a', *c);
+    ASSERT_EQ(1.5, *d);
+    ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(d) % alignof(double));
+
+    // larger than a block
+    auto big = static_cast<char *>(arena.Allocate(1024 * 1024, 16));
+    big[1024 * 1024 - 1] = 'z';
+    ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(big) % 16);
+}
+
+TEST_F(ArenaTestFixture, Release)
+{
+    auto counter = make_shared<int>(0);
+    {
+        Arena arena;
+        for (int i = 0; i < 10000; i++)
+            arena.New<shared_ptr<int>>(counter);
+        ASSERT_EQ(10001, counter.use_count());
+
+        arena.Release();
+        ASSERT_EQ(1, counter.use_count());
+        ASSERT_EQ(0u, arena.Bytes());
+
+        arena.New<shared_ptr<int>>(counter);
+    }
+    ASSERT_EQ(1, counter.use_count());
+}
+
+TEST_F(ArenaTestFixture, Tree)
+{
+    // the scanner and parser of the fixture allocate from its arena
+    auto p = GenerateParserFromSource("fun f(a) { return a + 1; } print f(2);");
+    auto stmts = p->Parse();
+    ASSERT_EQ(2u, stmts.size());
+    ASSERT_GT(mArena.Bytes(), 0u);
+}
@@ -26,41 +26,41 @@ class AstPrinterTestFixture : public CcloxTestFixtureBase
 TEST_F(AstPrinterTestFixture, expr_base)
 {
     // Literal
-    ASSERT_EQ("foo", p.Visit(Literal(make_shared<Object>("foo"))));
-    ASSERT_EQ("12.8", p.Visit(Literal(make_shared<Object>(12.8))));
+    ASSERT_EQ("foo", p.Visit(Literal(mArena.New<Object>("foo"))));
+    ASSERT_EQ("12.8", p.Visit(Literal(mArena.New<Object>(12.8))));
 
     // Binary
     ASSERT_EQ("(+ 3 5)",
-              p.Visit(Binary(make_shared<Literal>(make_shared<Object>(3)), make_shared<Token>(TOKEN_PLUS, "+", "", 1),
-                             make_shared<Literal>(make_shared<Object>(5)))));
+              p.Visit(Binary(mArena.New<Literal>(mArena.New<Object>(3)), mArena.New<Token>(TOKEN_PLUS, "+", "", 1),
+                             mArena.New<Literal>(mArena.New<Object>(5)))));
 
     // Assign
-    ASSERT_EQ("(= var 5)", p.Visit(Assign(make_shared<Token>(TOKEN_IDENTIFIER, "var", "var", 1),
-                                          make_shared<Literal>(make_shared<Object>(5)))));
+    ASSERT_EQ("(= var 5)", p.Visit(Assign(mArena.New<Token>(TOKEN_IDENTIFIER, "var", "var", 1),
+                                          mArena.New<Literal>(mArena.New<Object>(5)))));
 
     // Call
     ASSERT_EQ("(call myfunc  10 sval)",
-              p.Visit(Call(make_shared<Variable>(make_shared<Token>(TOKEN_IDENTIFIER, "myfunc", "myfunc", 1)), nullptr,
-                           vector<shared_ptr<Expr>>{
-                               make_shared<Literal>(make_shared<Object>(10)),
-                               make_shared<Literal>(make_shared<Object>("sval")),
+              p.Visit(Call(mArena.New<Variable>(mArena.New<Token>(TOKEN_IDENTIFIER, "myfunc", "myfunc", 1)), nullptr,
+                           vector<Expr *>{
+                               mArena.New<Literal>(mArena.New<Object>(10)),
+                               mArena.New<Literal>(mArena.New<Object>("sval")),
                            })));
 }
 
 TEST_F(AstPrinterTestFixture, stmt_base)
 {
     // Expression
-    ASSERT_EQ("(; 10)", p.Visit(Expression(make_shared<Literal>(make_shared<Object>(10)))));
+    ASSERT_EQ("(; 10)", p.Visit(Expression(mArena.New<Literal>(mArena.New<Object>(10)))));
 
     // Print
-    ASSERT_EQ("(print aaa)", p.Visit(Print(make_shared<Literal>(make_shared<Object>("aaa")))));
+    ASSERT_EQ("(print aaa)", p.Visit(Print(mArena.New<Literal>(mArena.New<Object>("aaa")))));
 }
 
 TEST_F(AstPrinterTestFixture, compound1)
 {
     ASSERT_EQ("(* (- 123) (group 45.67))",
-              p.Visit(Binary(make_shared<Unary>(make_shared<Token>(TOKEN_MINUS, "-", "", 1),
-                                                make_shared<Literal>(make_shared<Object>(123))),
-                             make_shared<Token>(TOKEN_STAR, "*", "", 1),
-                             make_shared<Grouping>(make_shared<Literal>(make_shared<Object>(45.67))))));
+              p.Visit(Binary(mArena.New<Unary>(mArena.New<Token>(TOKEN_MINUS, "-", "", 1),
+                                                mArena.New<Literal>(mArena.New<Object>(123))),
+                             mArena.New<Token>(TOKEN_STAR, "*", "", 1),
+                             mArena.New<Grouping>(mArena.New<Literal>(mArena.New<Object>(45.67))))));
 }
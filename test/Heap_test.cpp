@@ -0,0 +1,200 @@
+#include "Heap.h"
+#include "LoxClass.h"
+#include "LoxList.h"
+#include "LoxMap.h"
+#include "TestUtil.h"
+#include "VM.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using namespace lox;
+using namespace std;
+
+class HeapTestFixture : public CcloxTestFixtureBase
+{
+  public:
+    std::ostringstream testOs;
+
+    HeapTestFixture()
+    {
+    }
+    void SetUp()
+    {
+    }
+    void TearDown()
+    {
+    }
+
+    // closures stored in their own cell form a cycle per iteration
+    string CycleSource()
+    {
+        stringstream ss;
+        ss << "var last;" << endl;
+        ss << "for (var i = 0; i < 2000; i = i + 1) {" << endl;
+        ss << "  var x = \"str\" + \"ing\";" << endl;
+        ss << "  fun f() { return f; }" << endl;
+        ss << "  last = f;" << endl;
+        ss << "}" << endl;
+        ss << "print last() == last;" << endl;
+        return ss.str();
+    }
+
+    // only the storage of the lists and maps is large, the objects themselves are few
+    string ListSource()
+    {
+        stringstream ss;
+        ss << "var total = 0;" << endl;
+        ss << "for (var n = 0; n < 40; n = n + 1) {" << endl;
+        ss << "  var l = [];" << endl;
+        ss << "  var m = {};" << endl;
+        ss << "  for (var i = 0; i < 2000; i = i + 1) { push(l, i); m[i] = i; }" << endl;
+        ss << "  total = total + len(l) + len(m);" << endl;
+        ss << "}" << endl;
+        ss << "print total;" << endl;
+        return ss.str();
+    }
+};
+
+TEST_F(HeapTestFixture, Collect)
+{
+    Heap heap;
+    auto klass = heap.New<LoxClass>("A", nullptr, StringMap<Value>());
+    auto instance = heap.New<LoxInstance>(klass);
+    instance->SetField("self", Value(instance));
+    heap.Intern("garbage");
+
+    heap.Collect([=](Heap &heap) { heap.Mark(instance); });
+    ASSERT_EQ(1, heap.Stats().mObjectsFreed);
+    ASSERT_EQ(sizeof(LoxClass) + sizeof(LoxInstance), heap.Bytes());
+
+    // the cycle goes away once nothing refers to it
+    heap.Collect([](Heap &heap) {});
+    ASSERT_EQ(3, heap.Stats().mObjectsFreed);
+    ASSERT_EQ(0, heap.Bytes());
+    ASSERT_EQ(2, heap.Stats().mCollections);
+}
+
+TEST_F(HeapTestFixture, Threshold)
+{
+    Heap heap(GcConfig{64, 2.0, false});
+    ASSERT_FALSE(heap.ShouldCollect());
+
+    heap.Intern("a");
+    heap.Intern("b");
+    heap.Intern("c");
+    ASSERT_TRUE(heap.ShouldCollect());
+
+    heap.Collect([](Heap &heap) {});
+    ASSERT_FALSE(heap.ShouldCollect());
+}
+
+TEST_F(HeapTestFixture, Storage)
+{
+    Heap heap;
+    auto list = heap.New<LoxList>();
+    for (int i = 0; i < 100; i++)
+        list->Push(heap, Value(1.0 * i));
+    auto map = heap.New<LoxMap>();
+    for (int i = 0; i < 100; i++)
+        map->Set(heap, Value(1.0 * i), Value());
+    ASSERT_EQ(sizeof(LoxList) + list->StorageBytes() + sizeof(LoxMap) + map->StorageBytes(), heap.Bytes());
+    ASSERT_GE(heap.Bytes(), 100 * sizeof(Value) * 3);
+
+    heap.Collect([](Heap &heap) {});
+    ASSERT_EQ(0, heap.Bytes());
+}
+
+TEST_F(HeapTestFixture, Intern)
+{
+    Heap heap;
+    auto a = heap.Intern("abc");
+    ASSERT_EQ(a, heap.Intern(string("ab") + "c"));
+    ASSERT_NE(a, heap.Intern("abd"));
+    ASSERT_EQ(HashString("abc"), a->Hash());
+    ASSERT_EQ(2, heap.Stats().mObjectsAllocated);
+
+    // a collected string leaves the intern table, so the next one is a new object
+    heap.Collect([](Heap &heap) {});
+    heap.Intern("abc");
+    ASSERT_EQ(3, heap.Stats().mObjectsAllocated);
+}
+
+TEST_F(HeapTestFixture, InterpreterCycles)
+{
+    Interpreter i(testOs, GcConfig{4096, 2.0, false});
+    WithParsedAndResolvedStmts(i, CycleSource(), [&](const vector<Stmt *> &stmts) {
+        i.Interpret(stmts);
+
+        ASSERT_EQ("true\n", testOs.str());
+        ASSERT_GT(i.GetHeap().Stats().mCollections, 0);
+        ASSERT_LT(i.GetHeap().Stats().mPeakBytes, 3 * 4096);
+    });
+}
+
+TEST_F(HeapTestFixture, InterpreterStress)
+{
+    Interpreter i(testOs, GcConfig{0, 2.0, true});
+    WithParsedAndResolvedStmts(i, "class A { init(n) { this.n = n; } } var a = A(\"x\" + \"y\"); print a.n + \"z\";",
+                               [&](const vector<Stmt *> &stmts) {
+                                   i.Interpret(stmts);
+                                   ASSERT_EQ("xyz\n", testOs.str());
+                               });
+}
+
+TEST_F(HeapTestFixture, VmCycles)
+{
+    VM vm(testOs, GcConfig{4096, 2.0, false});
+    Scanner s(CycleSource(), mArena);
+    Parser p(s.ScanTokens(), mArena);
+    vm.Interpret(p.Parse());
+
+    ASSERT_EQ("true\n", testOs.str());
+    ASSERT_GT(vm.GetHeap().Stats().mCollections, 0);
+    ASSERT_LT(vm.GetHeap().Stats().mPeakBytes, 3 * 4096);
+}
+
+TEST_F(HeapTestFixture, ListStorage)
+{
+    const size_t threshold = 64 * 1024;
+    Interpreter i(testOs, GcConfig{threshold, 2.0, false});
+    WithParsedAndResolvedStmts(i, ListSource(), [&](const vector<Stmt *> &stmts) {
+        i.Interpret(stmts);
+        ASSERT_EQ("160000\n", testOs.str());
+        ASSERT_GT(i.GetHeap().Stats().mCollections, 0);
+        ASSERT_LT(i.GetHeap().Stats().mPeakBytes, 3 * threshold);
+    });
+
+    testOs.str("");
+    VM vm(testOs, GcConfig{threshold, 2.0, false});
+    Scanner s(ListSource(), mArena);
+    Parser p(s.ScanTokens(), mArena);
+    vm.Interpret(p.Parse());
+
+    ASSERT_EQ("160000\n", testOs.str());
+    ASSERT_GT(vm.GetHeap().Stats().mCollections, 0);
+    ASSERT_LT(vm.GetHeap().Stats().mPeakBytes, 3 * threshold);
+}
+
+TEST_F(HeapTestFixture, MapChurn)
+{
+    Heap heap;
+    auto map = heap.New<LoxMap>();
+    for (int i = 0; i < 100000; i++)
+    {
+        map->Set(heap, Value(1.0 * i), Value());
+        map->Delete(Value(1.0 * i));
+    }
+    ASSERT_EQ(0, map->Size());
+    // tombstones are dropped when the table is rehashed, they never make it grow
+    ASSERT_EQ(sizeof(LoxMap) + map->StorageBytes(), heap.Bytes());
+    ASSERT_LE(heap.Stats().mPeakBytes, sizeof(LoxMap) + 8 * 3 * sizeof(Value));
+
+    // overwriting keys of a map at its limit does not grow it either
+    for (int i = 0; i < 6; i++)
+        map->Set(heap, Value(1.0 * i), Value());
+    auto bytes = map->StorageBytes();
+    for (int i = 0; i < 6; i++)
+        ASSERT_FALSE(map->Set(heap, Value(1.0 * i), Value(true)));
+    ASSERT_EQ(bytes, map->StorageBytes());
+}
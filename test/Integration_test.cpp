@@ -26,11 +26,15 @@ class IntegrationTestFixture : public CcloxTestFixtureBase
         return "../test/integration_test/" + fileName;
     }
 
+    // every script has to behave the same on both engines
     void AssertOutput(const string &expected, const string &testFileName)
     {
-        std::ostringstream testOs;
-        Lox::RunFile(FilePath(testFileName), testOs);
-        ASSERT_EQ(expected, testOs.str());
+        for (auto engine : {ENGINE_TREE_WALKER, ENGINE_VM})
+        {
+            std::ostringstream testOs;
+            Lox::RunFile(FilePath(testFileName), testOs, engine);
+            ASSERT_EQ(expected, testOs.str());
+        }
     }
 };
 
@@ -40,6 +44,8 @@ TEST_F(IntegrationTestFixture, function)
                  "function/basic.lox");
 
     AssertOutput("9\n1\n2\n6\n7\n", "function/local_function_and_closures.lox");
+
+    AssertOutput("15\n501\n10\n15\n", "function/arguments.lox");
 }
 
 TEST_F(IntegrationTestFixture, class)
@@ -50,5 +56,37 @@ TEST_F(IntegrationTestFixture, class)
 
     AssertOutput("initializing\n1\n2\nb \nb \nBar instance\nhoge\nhoge\nHoge instance\n", "class/constructor.lox");
 
-    AssertOutput("Fry.\nFry.\nPipe.\nA method\n", "class/inheritance.lox");
+    AssertOutput("Fry.\nFry.\nPipe.\nA method\n3\n"
+                 "middle base\nbase\nextended base\nextended middle base\n",
+                 "class/inheritance.lox");
+}
+
+TEST_F(IntegrationTestFixture, native)
+{
+    AssertOutput("true\n1036\n5\nworld\n65\n13.5\nnil\nnil\nnil\nnil\nnil\n<native fn clock>\n4\n9\n",
+                 "native/basic.lox");
+
+    AssertOutput("nil\nnil\nnil\nnil\nnil\nnil\nnil\nnil\nnil\nnil\nnil\nnil\n-0.25\n7\n",
+                 "native/parse_nan.lox");
+}
+
+TEST_F(IntegrationTestFixture, list)
+{
+    AssertOutput("[1, two, nil]\ntwo\n3\n3\n4\n4\n0\n[0, 1, 4, 9, 16]\n[1, 4, 9]\n[[1, 4], [3]]\na\n30\n"
+                 "[[[...]]]\n",
+                 "list/basic.lox");
+}
+
+TEST_F(IntegrationTestFixture, map)
+{
+    AssertOutput("31\n27\nnil\n2\n4\ntrue\ntrue\nfalse\nfalse\n3\n"
+                 "one\none\nyes\nstring one\n{}\nzero\n3\n2\n1\n500\n500000\n{1: [{...}]}\n",
+                 "map/basic.lox");
+}
+
+TEST_F(IntegrationTestFixture, string)
+{
+    AssertOutput("2000\nab\ntrue\ntrue\nfalse\ntrue\n141\n89-01\n1\ntrue\ntrue\ntrue\ntrue\n"
+                 "<0123456789012345678901234567890123456789012345678901234567890123456789>\n",
+                 "string/concat.lox");
 }
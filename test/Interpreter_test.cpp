@@ -12,11 +12,15 @@ class InterpreterTestFixture : public CcloxTestFixtureBase
   public:
     std::ostringstream testOs;
     Interpreter i;
-    const Environment &iEnv;
+    const GlobalTable &iGlobals;
 
-    InterpreterTestFixture() : i(Interpreter(testOs)), iEnv(i.CEnvironment())
+    InterpreterTestFixture() : i(Interpreter(testOs)), iGlobals(i.Globals())
     {
     }
+    Value Global(const string &name)
+    {
+        return iGlobals.Get(iGlobals.Find(name));
+    }
     void SetUp()
     {
     }
@@ -29,27 +33,27 @@ TEST_F(InterpreterTestFixture, Literal)
 {
     auto p = GenerateParserFromSource("nil \"foobar\" 12.5 true");
 
-    ASSERT_EQ(nullptr, i.Visit(NextPrimaryAs<Literal>(p)));
+    ASSERT_TRUE(i.Visit(NextPrimaryAs<Literal>(p)).IsNil());
 
     auto strVal = i.Visit(NextPrimaryAs<Literal>(p));
-    ASSERT_EQ("foobar", strVal->AsString());
+    ASSERT_EQ("foobar", strVal.AsString());
 
     auto numVal = i.Visit(NextPrimaryAs<Literal>(p));
-    ASSERT_EQ(12.5, numVal->AsNumber());
+    ASSERT_EQ(12.5, numVal.AsNumber());
 
     auto boolVal = i.Visit(NextPrimaryAs<Literal>(p));
-    ASSERT_TRUE(boolVal->AsBoolean());
+    ASSERT_TRUE(boolVal.AsBoolean());
 }
 
 TEST_F(InterpreterTestFixture, Unary)
 {
     auto p = GenerateParserFromSource("-3 !false !!true !1 !\"aaa\"");
 
-    ASSERT_EQ(-3, i.Visit(NextUnary(p))->AsNumber());
-    ASSERT_EQ(true, i.Visit(NextUnary(p))->AsBoolean());
-    ASSERT_EQ(true, i.Visit(NextUnary(p))->AsBoolean());
-    ASSERT_EQ(false, i.Visit(NextUnary(p))->AsBoolean());
-    ASSERT_EQ(false, i.Visit(NextUnary(p))->AsBoolean());
+    ASSERT_EQ(-3, i.Visit(NextUnary(p)).AsNumber());
+    ASSERT_EQ(true, i.Visit(NextUnary(p)).AsBoolean());
+    ASSERT_EQ(true, i.Visit(NextUnary(p)).AsBoolean());
+    ASSERT_EQ(false, i.Visit(NextUnary(p)).AsBoolean());
+    ASSERT_EQ(false, i.Visit(NextUnary(p)).AsBoolean());
 }
 
 TEST_F(InterpreterTestFixture, Binary)
@@ -57,29 +61,29 @@ TEST_F(InterpreterTestFixture, Binary)
     auto p = GenerateParserFromSource("2*3 4/2 5+7 12-8 \"abc\"+\"de\" 1>2 3>=3 1<6 2<=1 3!=5 8==9 1+2*3-5");
 
     /* arithmetic */
-    ASSERT_EQ(6, i.Visit(NextFactor(p))->AsNumber());
-    ASSERT_EQ(2, i.Visit(NextFactor(p))->AsNumber());
-    ASSERT_EQ(12, i.Visit(NextTerm(p))->AsNumber());
-    ASSERT_EQ(4, i.Visit(NextTerm(p))->AsNumber());
+    ASSERT_EQ(6, i.Visit(NextFactor(p)).AsNumber());
+    ASSERT_EQ(2, i.Visit(NextFactor(p)).AsNumber());
+    ASSERT_EQ(12, i.Visit(NextTerm(p)).AsNumber());
+    ASSERT_EQ(4, i.Visit(NextTerm(p)).AsNumber());
     /* string append */
-    ASSERT_EQ("abcde", i.Visit(NextTerm(p))->AsString());
+    ASSERT_EQ("abcde", i.Visit(NextTerm(p)).AsString());
     /* comparison */
-    ASSERT_EQ(false, i.Visit(NextComparison(p))->AsBoolean());
-    ASSERT_EQ(true, i.Visit(NextComparison(p))->AsBoolean());
-    ASSERT_EQ(true, i.Visit(NextComparison(p))->AsBoolean());
-    ASSERT_EQ(false, i.Visit(NextComparison(p))->AsBoolean());
+    ASSERT_EQ(false, i.Visit(NextComparison(p)).AsBoolean());
+    ASSERT_EQ(true, i.Visit(NextComparison(p)).AsBoolean());
+    ASSERT_EQ(true, i.Visit(NextComparison(p)).AsBoolean());
+    ASSERT_EQ(false, i.Visit(NextComparison(p)).AsBoolean());
     /* equality */
-    ASSERT_EQ(true, i.Visit(NextEquality(p))->AsBoolean());
-    ASSERT_EQ(false, i.Visit(NextEquality(p))->AsBoolean());
+    ASSERT_EQ(true, i.Visit(NextEquality(p)).AsBoolean());
+    ASSERT_EQ(false, i.Visit(NextEquality(p)).AsBoolean());
 
     /* some compound case */
-    ASSERT_EQ(2, i.Visit(NextTerm(p))->AsNumber());
+    ASSERT_EQ(2, i.Visit(NextTerm(p)).AsNumber());
 }
 
 TEST_F(InterpreterTestFixture, Print)
 {
     WithParsedAndResolvedStmts(i, "print 1; print \"jack\"; print true; print nil;",
-                               [=, this](const vector<shared_ptr<Stmt>> &stmts) {
+                               [=, this](const vector<Stmt *> &stmts) {
                                    i.Interpret(stmts);
 
                                    ASSERT_EQ("1\njack\ntrue\nnil\n", testOs.str());
@@ -89,27 +93,44 @@ TEST_F(InterpreterTestFixture, Print)
 TEST_F(InterpreterTestFixture, Var)
 {
     WithParsedAndResolvedStmts(i, "var a; var b = 10; var s = \"hi\";",
-                               [=, this](const vector<shared_ptr<Stmt>> &stmts) {
+                               [=, this](const vector<Stmt *> &stmts) {
                                    i.Interpret(stmts);
 
-                                   ASSERT_FALSE(iEnv.Get(token("a")));
-                                   ASSERT_EQ(10, iEnv.Get(token("b"))->AsNumber());
-                                   ASSERT_EQ("hi", iEnv.Get(token("s"))->AsString());
+                                   ASSERT_TRUE(Global("a").IsNil());
+                                   ASSERT_EQ(10, Global("b").AsNumber());
+                                   ASSERT_EQ("hi", Global("s").AsString());
                                });
 }
 
 TEST_F(InterpreterTestFixture, Assign)
 {
     WithParsedAndResolvedStmts(i, "var a; var b; var c; a = 2; b = c = 3;",
-                               [=, this](const vector<shared_ptr<Stmt>> &stmts) {
+                               [=, this](const vector<Stmt *> &stmts) {
                                    i.Interpret(stmts);
 
-                                   ASSERT_EQ(2, iEnv.Get(token("a"))->AsNumber());
-                                   ASSERT_EQ(3, iEnv.Get(token("b"))->AsNumber());
-                                   ASSERT_EQ(3, iEnv.Get(token("c"))->AsNumber());
+                                   ASSERT_EQ(2, Global("a").AsNumber());
+                                   ASSERT_EQ(3, Global("b").AsNumber());
+                                   ASSERT_EQ(3, Global("c").AsNumber());
                                });
 }
 
+TEST_F(InterpreterTestFixture, RedefineGlobal)
+{
+    // every run is like a line typed into the REPL, sites cached by earlier lines keep seeing redefinitions
+    auto use = ParseAndResolve(i, "fun use() { return f() + a; }");
+    i.Interpret(use);
+    auto call = ParseAndResolve(i, "print use();");
+
+    i.Interpret(ParseAndResolve(i, "var a = 1; fun f() { return 10; }"));
+    i.Interpret(call);
+    i.Interpret(ParseAndResolve(i, "var a = 2; fun f() { return 20; }"));
+    i.Interpret(call);
+
+    ASSERT_FALSE(Lox::HadError());
+    ASSERT_EQ("11\n22\n", testOs.str());
+    ASSERT_EQ(2, Global("a").AsNumber());
+}
+
 TEST_F(InterpreterTestFixture, Block)
 {
     stringstream ss;
@@ -117,7 +138,7 @@ TEST_F(InterpreterTestFixture, Block)
     ss << "{ var a = 9; print a; print b; } ";
     ss << "print a; print b; " << endl;
 
-    WithParsedAndResolvedStmts(i, ss.str(), [=, this](const vector<shared_ptr<Stmt>> &stmts) {
+    WithParsedAndResolvedStmts(i, ss.str(), [=, this](const vector<Stmt *> &stmts) {
         i.Interpret(stmts);
 
         ASSERT_EQ("1\n2\n9\n2\n1\n2\n", testOs.str());
@@ -133,7 +154,7 @@ TEST_F(InterpreterTestFixture, If)
     ss << "if (false) print 3; else print 4; " << endl;
     ss << "if (false) print 5; else if (false) print 6; else print 7; " << endl;
 
-    WithParsedAndResolvedStmts(i, ss.str(), [=, this](const vector<shared_ptr<Stmt>> &stmts) {
+    WithParsedAndResolvedStmts(i, ss.str(), [=, this](const vector<Stmt *> &stmts) {
         i.Interpret(stmts);
 
         ASSERT_EQ("1\n3\n4\n7\n", testOs.str());
@@ -149,7 +170,7 @@ TEST_F(InterpreterTestFixture, Logical)
     ss << "print 0 or 4; " << endl;
     ss << "print \"s\" or 5; " << endl;
 
-    WithParsedAndResolvedStmts(i, ss.str(), [=, this](const vector<shared_ptr<Stmt>> &stmts) {
+    WithParsedAndResolvedStmts(i, ss.str(), [=, this](const vector<Stmt *> &stmts) {
         i.Interpret(stmts);
 
         ASSERT_EQ("1\n2\ntrue\n0\ns\n", testOs.str());
@@ -162,7 +183,7 @@ TEST_F(InterpreterTestFixture, While)
     ss << "var c = 0; while (c < 3) print c = c + 1;" << endl;
     ss << "var a = 0; while (a < 3) { print a; a = a + 1; }" << endl;
 
-    WithParsedAndResolvedStmts(i, ss.str(), [=, this](const vector<shared_ptr<Stmt>> &stmts) {
+    WithParsedAndResolvedStmts(i, ss.str(), [=, this](const vector<Stmt *> &stmts) {
         i.Interpret(stmts);
 
         ASSERT_EQ("1\n2\n3\n0\n1\n2\n", testOs.str());
@@ -175,9 +196,31 @@ TEST_F(InterpreterTestFixture, For)
     ss << "for (var c = 0; c < 3;) print c = c + 1;" << endl;
     ss << "for (var a = 0; a < 3; a = a + 1) { print a; }" << endl;
 
-    WithParsedAndResolvedStmts(i, ss.str(), [=, this](const vector<shared_ptr<Stmt>> &stmts) {
+    WithParsedAndResolvedStmts(i, ss.str(), [=, this](const vector<Stmt *> &stmts) {
         i.Interpret(stmts);
 
         ASSERT_EQ("1\n2\n3\n0\n1\n2\n", testOs.str());
     });
 }
+
+TEST_F(InterpreterTestFixture, Invoke)
+{
+    stringstream ss;
+    ss << "class A { init(v) { this.v = v; } add(x) { return this.v + x; } }" << endl;
+    ss << "fun twice(x) { return x * 2; }" << endl;
+    ss << "var a = A(1); a.f = twice;" << endl;
+    ss << "print a.add(2); print a.f(3);" << endl;
+    ss << "var m = a.add; a.v = 10; print m(1);" << endl;
+
+    WithParsedAndResolvedStmts(i, ss.str(), [=, this](const vector<Stmt *> &stmts) {
+        i.Interpret(stmts);
+
+        ASSERT_EQ("3\n6\n11\n", testOs.str());
+    });
+
+    // a method call needs its frame and nothing else
+    auto allocated = i.GetHeap().Stats().mObjectsAllocated;
+    WithParsedAndResolvedStmts(i, "var n = 0; while (n < 100) n = a.add(n) - 9;",
+                               [=, this](const vector<Stmt *> &stmts) { i.Interpret(stmts); });
+    ASSERT_LE(i.GetHeap().Stats().mObjectsAllocated - allocated, 100);
+}
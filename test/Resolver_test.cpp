@@ -1,4 +1,3 @@
-#include "Environment.h"
 #include "TestUtil.h"
 
 #include "gmock/gmock.h"
@@ -12,9 +11,8 @@ class ResolverTestFixture : public CcloxTestFixtureBase
   public:
     std::ostringstream testOs;
     Interpreter i;
-    const Environment &iEnv;
 
-    ResolverTestFixture() : i(Interpreter(testOs)), iEnv(i.CEnvironment())
+    ResolverTestFixture() : i(Interpreter(testOs))
     {
     }
     void SetUp()
@@ -59,3 +57,97 @@ TEST_F(ResolverTestFixture, InvalidThis)
     ASSERT_TRUE(Lox::HadError());
     Lox::ResetError();
 }
+
+TEST_F(ResolverTestFixture, Slots)
+{
+    stringstream ss;
+    ss << "{ var a = 1; var b = 2; { var c = 3; print a + b + c; b = 10; } print b; }" << endl;
+    ss << "fun f(x, y) { var z = x * y; fun g() { return x + z; } return g(); }" << endl;
+    ss << "print f(2, 3);" << endl;
+
+    WithParsedAndResolvedStmts(i, ss.str(), [=, this](const vector<Stmt *> &stmts) {
+        i.Interpret(stmts);
+
+        ASSERT_EQ("6\n10\n8\n", testOs.str());
+    });
+}
+
+TEST_F(ResolverTestFixture, AnnotatesNodes)
+{
+    auto stmts = ParseAndResolve(i, "var g; { var a; var b; print b; print g; }");
+    ASSERT_FALSE(Lox::HadError());
+
+    auto block = static_cast<Block *>(stmts[1]);
+    auto local = static_cast<Variable *>(static_cast<Print *>(block->mStatements[2])->mExpression);
+    ASSERT_EQ(SLOT_LOCAL, local->mSlot.mKind);
+    ASSERT_EQ(1, local->mSlot.mIndex);
+
+    auto global = static_cast<Variable *>(static_cast<Print *>(block->mStatements[3])->mExpression);
+    ASSERT_FALSE(global->mSlot.IsResolved());
+}
+
+TEST_F(ResolverTestFixture, FrameSlots)
+{
+    stringstream ss;
+    ss << "fun f(x) {" << endl;
+    ss << "  { print x; }" << endl;
+    ss << "  { var a = x; { var b = a; print b; } }" << endl;
+    ss << "  var c = 3;" << endl;
+    ss << "  { var d; print d; fun g() { return d + x; } }" << endl;
+    ss << "  return c;" << endl;
+    ss << "}" << endl;
+    auto stmts = ParseAndResolve(i, ss.str());
+    ASSERT_FALSE(Lox::HadError());
+    auto f = static_cast<Function *>(stmts[0]);
+    auto &body = f->mBody;
+
+    // the locals of blocks take the slots after x in the frame of f
+    auto outer = static_cast<Block *>(body[1]);
+    auto inner = static_cast<Block *>(outer->mStatements[1]);
+    ASSERT_EQ(1, static_cast<Var *>(outer->mStatements[0])->mSlot.mIndex);
+    auto b = static_cast<Variable *>(static_cast<Print *>(inner->mStatements[1])->mExpression);
+    ASSERT_EQ(SLOT_LOCAL, b->mSlot.mKind);
+    ASSERT_EQ(2, b->mSlot.mIndex);
+
+    // the slots of a and b are free again once their blocks end
+    ASSERT_EQ(1, static_cast<Var *>(body[2])->mSlot.mIndex);
+
+    // g captures d and x, so they live in cells, also for the sites resolved before g
+    auto last = static_cast<Block *>(body[3])->mStatements;
+    ASSERT_EQ(SLOT_CELL, static_cast<Var *>(last[0])->mSlot.mKind);
+    ASSERT_EQ(SLOT_CELL, static_cast<Variable *>(static_cast<Print *>(last[1])->mExpression)->mSlot.mKind);
+    auto x = static_cast<Variable *>(static_cast<Print *>(static_cast<Block *>(body[0])->mStatements[0])->mExpression);
+    ASSERT_EQ(SLOT_CELL, x->mSlot.mKind);
+    ASSERT_EQ(vector<int>{0}, f->mFrame.mCells);
+
+    auto g = static_cast<Function *>(last[2]);
+    ASSERT_EQ(SLOT_LOCAL, g->mSlot.mKind);
+    ASSERT_EQ(2u, g->mFrame.mUpvalues.size());
+    ASSERT_TRUE(g->mFrame.mUpvalues[0].mIsLocal);
+    ASSERT_EQ(2, g->mFrame.mUpvalues[0].mIndex);
+    ASSERT_EQ(0, g->mFrame.mUpvalues[1].mIndex);
+
+    // x, d, and g are in use at once
+    ASSERT_EQ(4, f->mFrame.mSize);
+}
+
+TEST_F(ResolverTestFixture, ElidedScopesRun)
+{
+    stringstream ss;
+    ss << "fun f(n) {" << endl;
+    ss << "  var sum = 0;" << endl;
+    ss << "  for (var i = 0; i < n; i = i + 1) { var square = i * i; sum = sum + square; }" << endl;
+    ss << "  var after = 1;" << endl;
+    ss << "  var closures = 0;" << endl;
+    ss << "  for (var i = 0; i < 2; i = i + 1) { var j = i; fun get() { return j; }" << endl;
+    ss << "    closures = closures + get(); }" << endl;
+    ss << "  return sum + after + closures;" << endl;
+    ss << "}" << endl;
+    ss << "print f(4);" << endl;
+
+    WithParsedAndResolvedStmts(i, ss.str(), [=, this](const vector<Stmt *> &stmts) {
+        i.Interpret(stmts);
+
+        ASSERT_EQ("16\n", testOs.str());
+    });
+}
@@ -25,8 +25,8 @@ class ScannerTestFixture : public CcloxTestFixtureBase
 
 TEST_F(ScannerTestFixture, basic_tokens)
 {
-    Scanner s("(){},.-+;*!!=<<=>>===");
-    const vector<shared_ptr<Token>> &tokens = s.ScanTokens();
+    Scanner s("(){},.-+;*!!=<<=>>===", mArena);
+    const vector<Token *> &tokens = s.ScanTokens();
 
     vector<TokenType> expecteds{
         TOKEN_LEFT_PAREN, TOKEN_RIGHT_PAREN, TOKEN_LEFT_BRACE, TOKEN_RIGHT_BRACE,   TOKEN_COMMA,       TOKEN_DOT,
@@ -41,8 +41,8 @@ TEST_F(ScannerTestFixture, basic_tokens)
 
 TEST_F(ScannerTestFixture, whitespace)
 {
-    Scanner s("a b \t\r e\nd");
-    const vector<shared_ptr<Token>> &tokens = s.ScanTokens();
+    Scanner s("a b \t\r e\nd", mArena);
+    const vector<Token *> &tokens = s.ScanTokens();
 
     ASSERT_EQ(5, tokens.size());
     for (size_t i = 0; i < tokens.size() - 1; i++)
@@ -53,8 +53,8 @@ TEST_F(ScannerTestFixture, whitespace)
 
 TEST_F(ScannerTestFixture, number)
 {
-    Scanner s("12 4 78.9");
-    const vector<shared_ptr<Token>> &tokens = s.ScanTokens();
+    Scanner s("12 4 78.9", mArena);
+    const vector<Token *> &tokens = s.ScanTokens();
 
     vector<string> expecteds{"12", "4", "78.9"};
 
@@ -71,8 +71,8 @@ TEST_F(ScannerTestFixture, string)
 {
     Scanner s("\"foo\""
               "\"bar\""
-              "\"hoge\nfuga\"");
-    const vector<shared_ptr<Token>> &tokens = s.ScanTokens();
+              "\"hoge\nfuga\"", mArena);
+    const vector<Token *> &tokens = s.ScanTokens();
 
     vector<string> expecteds{"foo", "bar", "hoge\nfuga"};
 
@@ -92,8 +92,8 @@ TEST_F(ScannerTestFixture, string)
 
 TEST_F(ScannerTestFixture, line)
 {
-    Scanner s("1\n2\n3");
-    const vector<shared_ptr<Token>> &tokens = s.ScanTokens();
+    Scanner s("1\n2\n3", mArena);
+    const vector<Token *> &tokens = s.ScanTokens();
 
     vector<int> expecteds{1, 2, 3};
 
@@ -106,8 +106,8 @@ TEST_F(ScannerTestFixture, line)
 
 TEST_F(ScannerTestFixture, keywords)
 {
-    Scanner s("if else for");
-    const vector<shared_ptr<Token>> &tokens = s.ScanTokens();
+    Scanner s("if else for", mArena);
+    const vector<Token *> &tokens = s.ScanTokens();
 
     vector<int> expecteds{TOKEN_IF, TOKEN_ELSE, TOKEN_FOR};
 
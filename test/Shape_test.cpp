@@ -0,0 +1,128 @@
+#include "Heap.h"
+#include "LoxClass.h"
+#include "Shape.h"
+#include "TestUtil.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using namespace lox;
+using namespace std;
+
+class ShapeTestFixture : public CcloxTestFixtureBase
+{
+  public:
+    Heap heap;
+    std::ostringstream testOs;
+
+    ShapeTestFixture()
+    {
+    }
+    void SetUp()
+    {
+    }
+    void TearDown()
+    {
+    }
+
+    LoxInstance *NewInstance(LoxClass *klass, const vector<string> &fields)
+    {
+        auto instance = heap.New<LoxInstance>(klass);
+        for (size_t i = 0; i < fields.size(); i++)
+            instance->SetField(fields[i], Value(static_cast<double>(i)));
+        return instance;
+    }
+};
+
+TEST_F(ShapeTestFixture, Transitions)
+{
+    auto klass = heap.New<LoxClass>("A", nullptr, StringMap<Value>());
+    auto transitions = Shape::Stats().mTransitions;
+
+    auto a = NewInstance(klass, {"x", "y"});
+    auto b = NewInstance(klass, {"x", "y"});
+    auto c = NewInstance(klass, {"y", "x"});
+
+    ASSERT_EQ(a->GetShape(), b->GetShape());
+    ASSERT_NE(a->GetShape(), c->GetShape());
+    ASSERT_EQ(transitions + 4, Shape::Stats().mTransitions);
+
+    // assigning an existing field keeps the shape
+    auto shape = a->GetShape();
+    a->SetField("x", Value(10.0));
+    ASSERT_EQ(shape, a->GetShape());
+
+    Value value;
+    ASSERT_TRUE(a->GetField("x", value));
+    ASSERT_EQ(10, value.AsNumber());
+    ASSERT_TRUE(c->GetField("x", value));
+    ASSERT_EQ(1, value.AsNumber());
+    ASSERT_FALSE(a->GetField("z", value));
+}
+
+TEST_F(ShapeTestFixture, OverflowSlots)
+{
+    auto klass = heap.New<LoxClass>("A", nullptr, StringMap<Value>());
+    auto instance = NewInstance(klass, {"a", "b", "c", "d", "e", "f"});
+
+    ASSERT_EQ(6, instance->GetShape()->SlotCount());
+    for (int i = 0; i < 6; i++)
+        ASSERT_EQ(i, instance->SlotAt(i).AsNumber());
+
+    Value value;
+    ASSERT_TRUE(instance->GetField("f", value));
+    ASSERT_EQ(5, value.AsNumber());
+}
+
+TEST_F(ShapeTestFixture, MegamorphicSite)
+{
+    Interpreter i(testOs);
+    stringstream ss;
+    ss << "class A {}" << endl;
+    ss << "fun getX(o) { return o.x; }" << endl;
+    ss << "var o1 = A(); o1.x = 1;" << endl;
+    ss << "var o2 = A(); o2.a = 0; o2.x = 2;" << endl;
+    ss << "var o3 = A(); o3.b = 0; o3.x = 3;" << endl;
+    ss << "var o4 = A(); o4.c = 0; o4.x = 4;" << endl;
+    ss << "var o5 = A(); o5.d = 0; o5.x = 5;" << endl;
+    ss << "print getX(o1) + getX(o2) + getX(o3) + getX(o4);" << endl;
+
+    auto megamorphic = Shape::Stats().mMegamorphicSites;
+    WithParsedAndResolvedStmts(i, ss.str() + "print getX(o5);", [&](const vector<Stmt *> &stmts) {
+        i.Interpret(stmts);
+
+        ASSERT_EQ("10\n5\n", testOs.str());
+        ASSERT_EQ(megamorphic + 1, Shape::Stats().mMegamorphicSites);
+    });
+}
+
+TEST_F(ShapeTestFixture, InlineCache)
+{
+    Interpreter i(testOs);
+    stringstream ss;
+    ss << "class A { init(x) { this.x = x; } m() { return \"m\"; } }" << endl;
+    ss << "class B < A {}" << endl;
+    ss << "var objs = A(1); var b = B(2); var c = A(3); c.m = \"field\";" << endl;
+    ss << "fun get(o) { return o.x; }" << endl;
+    ss << "fun call(o) { return o.m; }" << endl;
+    ss << "print get(objs) + get(c) + get(objs);" << endl;
+    ss << "print get(b);" << endl;
+    ss << "print call(objs)() + call(b)() + call(c) + call(objs)();" << endl;
+
+    WithParsedAndResolvedStmts(i, ss.str(), [&](const vector<Stmt *> &stmts) {
+        i.Interpret(stmts);
+
+        ASSERT_EQ("5\n2\nmmfieldm\n", testOs.str());
+
+        // instances of A and B start from the root shapes of their own classes
+        auto &init = *static_cast<Class *>(stmts[0])->mMethods[0];
+        auto &set = *static_cast<Set *>(static_cast<Expression *>(init.mBody[0])->mExpression);
+        ASSERT_FALSE(set.mSite.IsMonomorphic());
+        ASSERT_FALSE(set.mSite.IsMegamorphic());
+
+        auto &get = *static_cast<Get *>(
+            static_cast<Return *>(static_cast<Function *>(stmts[6])->mBody[0])->mValue);
+        ASSERT_FALSE(get.mSite.IsMonomorphic());
+        ASSERT_FALSE(get.mSite.IsMegamorphic());
+    });
+}
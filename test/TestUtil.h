@@ -26,31 +26,31 @@ class CcloxTestFixtureBase : public ::testing::Test
 
     shared_ptr<Parser> GenerateParserFromSource(const string &source)
     {
-        Scanner s(source);
-        return make_shared<Parser>(s.ScanTokens());
+        Scanner s(source, mArena);
+        return make_shared<Parser>(s.ScanTokens(), mArena);
     }
 
-    vector<shared_ptr<Stmt>> ParseAndResolve(Interpreter &interpreter, const string &source)
+    vector<Stmt *> ParseAndResolve(Interpreter &interpreter, const string &source)
     {
-        Scanner s(source);
-        Parser p(s.ScanTokens());
+        Scanner s(source, mArena);
+        Parser p(s.ScanTokens(), mArena);
 
         auto stmts = p.Parse();
 
         if (Lox::HadError())
-            return vector<shared_ptr<Stmt>>();
+            return vector<Stmt *>();
 
-        Resolver r(interpreter);
+        Resolver r;
         r.Resolve(stmts);
 
         if (Lox::HadError())
-            return vector<shared_ptr<Stmt>>();
+            return vector<Stmt *>();
 
         return stmts;
     }
 
     void WithParsedAndResolvedStmts(Interpreter &interpreter, const string &source,
-                                    const function<void(const vector<shared_ptr<Stmt>> &stmts)> &proc)
+                                    const function<void(const vector<Stmt *> &stmts)> &proc)
     {
         auto stmts = ParseAndResolve(interpreter, source);
 
@@ -62,21 +62,19 @@ class CcloxTestFixtureBase : public ::testing::Test
         Lox::ResetError();
     }
 
-    shared_ptr<Token> token(const string &s)
+    Token *token(const string &s)
     {
-        return make_shared<Token>(TOKEN_IDENTIFIER, s, s, 1);
+        return mArena.New<Token>(TOKEN_IDENTIFIER, s, s, 1);
     }
 
-    template <typename T> T As(shared_ptr<Expr> expr)
+    template <typename T> T As(Expr *expr)
     {
-        shared_ptr<T> tp = static_pointer_cast<T>(expr);
-        return *tp;
+        return *static_cast<T *>(expr);
     }
 
-    template <typename T> T As(shared_ptr<Stmt> expr)
+    template <typename T> T As(Stmt *expr)
     {
-        shared_ptr<T> tp = static_pointer_cast<T>(expr);
-        return *tp;
+        return *static_cast<T *>(expr);
     }
 
     template <typename T> T NextPrimaryAs(shared_ptr<Parser> &p)
@@ -112,4 +110,8 @@ class CcloxTestFixtureBase : public ::testing::Test
     {
         return As<T>(p->ParseDeclaration());
     }
+
+  protected:
+    // owns the tokens and nodes of every source parsed by the test
+    Arena mArena;
 };
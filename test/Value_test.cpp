@@ -1,6 +1,10 @@
+#include "Heap.h"
 #include "TestUtil.h"
 #include "Value.h"
 
+#include <cmath>
+#include <cstring>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -10,6 +14,8 @@ using namespace std;
 class ValueTestFixture : public CcloxTestFixtureBase
 {
   public:
+    Heap heap;
+
     ValueTestFixture()
     {
     }
@@ -23,57 +29,103 @@ class ValueTestFixture : public CcloxTestFixtureBase
 
 TEST_F(ValueTestFixture, StringValue)
 {
-    shared_ptr<Value> v = make_shared<StringValue>("someStr");
-    ASSERT_THROW(v->AsNumber(), UnsupposedValueOperationError);
-    ASSERT_THROW(v->AsBoolean(), UnsupposedValueOperationError);
-    ASSERT_EQ(v->AsString(), "someStr");
+    Value v(heap.Intern("someStr"));
+    ASSERT_THROW(v.AsNumber(), UnsupposedValueOperationError);
+    ASSERT_THROW(v.AsBoolean(), UnsupposedValueOperationError);
+    ASSERT_EQ(v.AsString(), "someStr");
 
-    ASSERT_FALSE(v->IsBoolean());
-    ASSERT_FALSE(v->IsNumber());
-    ASSERT_TRUE(v->IsString());
+    ASSERT_FALSE(v.IsBoolean());
+    ASSERT_FALSE(v.IsNumber());
+    ASSERT_FALSE(v.IsNil());
+    ASSERT_TRUE(v.IsString());
 
-    ASSERT_FALSE(v->Equals(NumberValue(1)));
-    ASSERT_FALSE(v->Equals(BooleanValue(true)));
-    ASSERT_FALSE(v->Equals(StringValue("someOtherStr")));
-    ASSERT_TRUE(v->Equals(StringValue("someStr")));
+    ASSERT_FALSE(v.Equals(Value(1.0)));
+    ASSERT_FALSE(v.Equals(Value(true)));
+    ASSERT_FALSE(v.Equals(Value(heap.Intern("someOtherStr"))));
+    ASSERT_TRUE(v.Equals(Value(heap.Intern("someStr"))));
 
-    ASSERT_EQ(v->Str(), "someStr");
+    ASSERT_EQ(v.Str(), "someStr");
 }
 
 TEST_F(ValueTestFixture, NumberValue)
 {
-    shared_ptr<Value> v = make_shared<NumberValue>(98.4);
-    ASSERT_THROW(v->AsString(), UnsupposedValueOperationError);
-    ASSERT_THROW(v->AsBoolean(), UnsupposedValueOperationError);
-    ASSERT_EQ(v->AsNumber(), 98.4);
+    Value v(98.4);
+    ASSERT_THROW(v.AsString(), UnsupposedValueOperationError);
+    ASSERT_THROW(v.AsBoolean(), UnsupposedValueOperationError);
+    ASSERT_EQ(v.AsNumber(), 98.4);
+
+    ASSERT_FALSE(v.IsString());
+    ASSERT_FALSE(v.IsBoolean());
+    ASSERT_FALSE(v.IsNil());
+    ASSERT_TRUE(v.IsNumber());
+
+    ASSERT_FALSE(v.Equals(Value(true)));
+    ASSERT_FALSE(v.Equals(Value(heap.Intern("someStr"))));
+    ASSERT_FALSE(v.Equals(Value(1.0)));
+    ASSERT_TRUE(v.Equals(Value(98.4)));
 
-    ASSERT_FALSE(v->IsString());
-    ASSERT_FALSE(v->IsBoolean());
-    ASSERT_TRUE(v->IsNumber());
+    ASSERT_EQ(v.Str(), "98.4");
 
-    ASSERT_FALSE(v->Equals(BooleanValue(true)));
-    ASSERT_FALSE(v->Equals(StringValue("someStr")));
-    ASSERT_FALSE(v->Equals(NumberValue(1)));
-    ASSERT_TRUE(v->Equals(NumberValue(98.4)));
+    Value negative(-0.5);
+    ASSERT_TRUE(negative.IsNumber());
+    ASSERT_EQ(negative.AsNumber(), -0.5);
 
-    ASSERT_EQ(v->Str(), "98.4");
+    Value nan(0.0 / 0.0);
+    ASSERT_TRUE(nan.IsNumber());
+    ASSERT_FALSE(nan.Equals(nan));
+}
+
+TEST_F(ValueTestFixture, PayloadNaN)
+{
+    // NaNs whose bits would otherwise read as nil or as an object pointer
+    for (uint64_t bits : {0x7ffc000000000001ull, 0xfffc000000001000ull, 0x7ff4000000000001ull})
+    {
+        double number;
+        std::memcpy(&number, &bits, sizeof(double));
+        Value v(number);
+        ASSERT_TRUE(v.IsNumber());
+        ASSERT_FALSE(v.IsNil());
+        ASSERT_FALSE(v.IsObj());
+        ASSERT_TRUE(std::isnan(v.AsNumber()));
+        ASSERT_FALSE(v.Equals(v));
+        ASSERT_EQ(v.Str(), "nan");
+    }
 }
 
 TEST_F(ValueTestFixture, BooleanValue)
 {
-    shared_ptr<Value> v = make_shared<BooleanValue>(true);
-    ASSERT_THROW(v->AsString(), UnsupposedValueOperationError);
-    ASSERT_THROW(v->AsNumber(), UnsupposedValueOperationError);
-    ASSERT_EQ(v->AsBoolean(), true);
+    Value v(true);
+    ASSERT_THROW(v.AsString(), UnsupposedValueOperationError);
+    ASSERT_THROW(v.AsNumber(), UnsupposedValueOperationError);
+    ASSERT_EQ(v.AsBoolean(), true);
+
+    ASSERT_FALSE(v.IsString());
+    ASSERT_FALSE(v.IsNumber());
+    ASSERT_FALSE(v.IsNil());
+    ASSERT_TRUE(v.IsBoolean());
+
+    ASSERT_FALSE(v.Equals(Value(heap.Intern("someStr"))));
+    ASSERT_FALSE(v.Equals(Value(1.0)));
+    ASSERT_FALSE(v.Equals(Value(false)));
+    ASSERT_TRUE(v.Equals(Value(true)));
+
+    ASSERT_EQ(v.Str(), "true");
+    ASSERT_EQ(Value(false).Str(), "false");
+}
+
+TEST_F(ValueTestFixture, NilValue)
+{
+    Value v;
+    ASSERT_THROW(v.AsNumber(), UnsupposedValueOperationError);
+    ASSERT_THROW(v.AsBoolean(), UnsupposedValueOperationError);
 
-    ASSERT_FALSE(v->IsString());
-    ASSERT_FALSE(v->IsNumber());
-    ASSERT_TRUE(v->IsBoolean());
+    ASSERT_TRUE(v.IsNil());
+    ASSERT_FALSE(v.IsBoolean());
+    ASSERT_FALSE(v.IsNumber());
+    ASSERT_FALSE(v.IsObj());
 
-    ASSERT_FALSE(v->Equals(StringValue("someStr")));
-    ASSERT_FALSE(v->Equals(NumberValue(1)));
-    ASSERT_FALSE(v->Equals(BooleanValue(false)));
-    ASSERT_TRUE(v->Equals(BooleanValue(true)));
+    ASSERT_TRUE(v.Equals(Value()));
+    ASSERT_FALSE(v.Equals(Value(false)));
 
-    ASSERT_EQ(v->Str(), "true");
+    ASSERT_EQ(v.Str(), "nil");
 }
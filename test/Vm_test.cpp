@@ -0,0 +1,175 @@
+#include "TestUtil.h"
+#include "VM.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using namespace lox;
+using namespace std;
+
+class VmTestFixture : public CcloxTestFixtureBase
+{
+  public:
+    std::ostringstream testOs;
+    VM vm;
+
+    VmTestFixture() : vm(testOs)
+    {
+    }
+    void SetUp()
+    {
+    }
+    void TearDown()
+    {
+    }
+
+    string Run(const string &source)
+    {
+        Scanner s(source, mArena);
+        Parser p(s.ScanTokens(), mArena);
+        auto stmts = p.Parse();
+
+        testOs.str("");
+        vm.Interpret(stmts);
+        return testOs.str();
+    }
+};
+
+TEST_F(VmTestFixture, Expressions)
+{
+    ASSERT_EQ("7\n", Run("print 1 + 2 * 3;"));
+    ASSERT_EQ("true\n", Run("print !(1 >= 2) and 3 != 4;"));
+    ASSERT_EQ("ab\n", Run("print \"a\" + \"b\";"));
+    ASSERT_EQ("nil\n", Run("print nil or nil;"));
+}
+
+TEST_F(VmTestFixture, Globals)
+{
+    Run("var a = 1;");
+    ASSERT_EQ("2\n", Run("a = a + 1; print a;"));
+
+    // slots survive across runs, like lines typed into the REPL
+    ASSERT_TRUE(vm.Globals().IsDefined(0));
+}
+
+TEST_F(VmTestFixture, Closures)
+{
+    stringstream ss;
+    ss << "fun counter() { var i = 0; fun inc() { i = i + 1; return i; } return inc; }" << endl;
+    ss << "var c = counter(); c(); print c();" << endl;
+    ss << "var fs; { var x = 1; fun f() { print x; } fs = f; x = 2; } fs();" << endl;
+    ss << "for (var i = 0; i < 3; i = i + 1) { var j = i; fun g() { return j; } print g(); }" << endl;
+
+    ASSERT_EQ("2\n2\n0\n1\n2\n", Run(ss.str()));
+}
+
+TEST_F(VmTestFixture, Classes)
+{
+    stringstream ss;
+    ss << "class A { init(n) { this.n = n; } get() { return this.n; } }" << endl;
+    ss << "class B < A { get() { return super.get() * 10; } }" << endl;
+    ss << "var b = B(4); print b.get(); var m = b.get; print m();" << endl;
+    ss << "b.f = A; print b.f(1).n;" << endl;
+
+    ASSERT_EQ("40\n40\n1\n", Run(ss.str()));
+}
+
+TEST_F(VmTestFixture, Disassemble)
+{
+    stringstream ss;
+    ss << "{" << endl;
+    ss << "  fun twice(x) { return x * 2; }" << endl;
+    ss << "  print twice(3);" << endl;
+    ss << "}" << endl;
+
+    std::ostringstream listing;
+    vm.SetDisassembly(&listing);
+    ASSERT_EQ("6\n", Run(ss.str()));
+
+    // functions are listed after the chunk that creates them
+    ASSERT_EQ("== <script> ==\n"
+              "0000    2 OP_CLOSURE       0 <fn twice>\n"
+              "0003    3 OP_GET_LOCAL     1\n"
+              "0005    | OP_CONSTANT      1 '3'\n"
+              "0008    | OP_CALL          1\n"
+              "0010    | OP_PRINT\n"
+              "0011    | OP_POP\n"
+              "0012    | OP_NIL\n"
+              "0013    | OP_RETURN\n"
+              "== <fn twice> ==\n"
+              "0000    2 OP_GET_LOCAL     1\n"
+              "0002    | OP_CONSTANT      0 '2'\n"
+              "0005    | OP_MULTIPLY\n"
+              "0006    | OP_RETURN\n"
+              "0007    | OP_NIL\n"
+              "0008    | OP_RETURN\n",
+              listing.str());
+}
+
+TEST_F(VmTestFixture, RuntimeError)
+{
+    ASSERT_EQ("", Run("print -\"a\";"));
+    ASSERT_TRUE(Lox::HadError());
+    Lox::ResetError();
+
+    ASSERT_EQ("", Run("print undefined;"));
+    ASSERT_TRUE(Lox::HadError());
+    Lox::ResetError();
+
+    ASSERT_EQ("", Run("fun f() { f(); } f();"));
+    ASSERT_TRUE(Lox::HadError());
+    Lox::ResetError();
+
+    // the stack is reset after an error
+    ASSERT_EQ("1\n", Run("print 1;"));
+}
+
+TEST_F(VmTestFixture, ExpressionStackOverflow)
+{
+    // every level of nesting keeps a temporary on the stack while the recursive call runs
+    const int nesting = 450;
+    stringstream ss;
+    ss << "fun f(d) { if (d == 0) return 0; return ";
+    for (int i = 0; i < nesting; i++)
+        ss << "1 + (";
+    ss << "f(d - 1)";
+    for (int i = 0; i < nesting; i++)
+        ss << ")";
+    ss << "; }" << endl;
+
+    ASSERT_EQ("45000\n", Run(ss.str() + "print f(100);"));
+
+    ASSERT_EQ("", Run(ss.str() + "print f(1000);"));
+    ASSERT_TRUE(Lox::HadError());
+    Lox::ResetError();
+
+    ASSERT_EQ("1\n", Run("print 1;"));
+}
+
+TEST_F(VmTestFixture, LiteralStackOverflow)
+{
+    // every level pushes its elements before evaluating the nested literal last
+    auto nested = [](int depth, int count) {
+        stringstream ss;
+        ss << "var l = ";
+        for (int d = 0; d < depth; d++)
+        {
+            ss << "[";
+            for (int i = 0; i < count; i++)
+                ss << "nil, ";
+        }
+        ss << "0";
+        for (int d = 0; d < depth; d++)
+            ss << "]";
+        ss << "; print len(l);";
+        return ss.str();
+    };
+
+    ASSERT_EQ("301\n", Run(nested(3, 300)));
+
+    ASSERT_EQ("", Run(nested(5, 65000)));
+    ASSERT_TRUE(Lox::HadError());
+    Lox::ResetError();
+
+    ASSERT_EQ("1\n", Run("print 1;"));
+}
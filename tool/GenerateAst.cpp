@@ -7,36 +7,59 @@
 
 using namespace std;
 
+// nodes are allocated from an Arena and reference each other (and their tokens) with raw pointers
 const static map<string, string> exprs = {
-    {"Assign", "shared_ptr<Token> name, shared_ptr<Expr> value"},
-    {"Binary", "shared_ptr<Expr> left, shared_ptr<Token> op, shared_ptr<Expr> right"},
-    {"Call", "shared_ptr<Expr> callee, shared_ptr<Token> paren, vector<shared_ptr<Expr>> arguments"},
-    {"Get", "shared_ptr<Expr> object, shared_ptr<Token> name"},
-    {"Grouping", "shared_ptr<Expr> expression"},
-    {"Literal", "shared_ptr<Object> value"},
-    {"Logical", "shared_ptr<Expr> left, shared_ptr<Token> op, shared_ptr<Expr> right"},
-    {"Set", "shared_ptr<Expr> object, shared_ptr<Token> name, shared_ptr<Expr> value"},
-    {"Super", "shared_ptr<Token> keyword, shared_ptr<Token> method"},
-    {"This", "shared_ptr<Token> keyword"},
-    {"Unary", "shared_ptr<Token> op, shared_ptr<Expr> right"},
-    {"Variable", "shared_ptr<Token> name"},
+    {"Assign", "Token* name, Expr* value"},
+    {"Binary", "Expr* left, Token* op, Expr* right"},
+    {"Call", "Expr* callee, Token* paren, vector<Expr*> arguments"},
+    {"Get", "Expr* object, Token* name"},
+    {"Grouping", "Expr* expression"},
+    {"Index", "Expr* object, Token* bracket, Expr* index"},
+    {"ListLiteral", "Token* bracket, vector<Expr*> elements"},
+    {"Literal", "Object* value"},
+    {"MapLiteral", "Token* brace, vector<Expr*> keys, vector<Expr*> values"},
+    {"Logical", "Expr* left, Token* op, Expr* right"},
+    {"Set", "Expr* object, Token* name, Expr* value"},
+    {"SetIndex", "Expr* object, Token* bracket, Expr* index, Expr* value"},
+    {"Super", "Token* keyword, Token* method"},
+    {"This", "Token* keyword"},
+    {"Unary", "Token* op, Expr* right"},
+    {"Variable", "Token* name"},
 };
 
 const static map<string, string> stmts = {
-    {"Expression", "shared_ptr<Expr> expression"},
-    {"Print", "shared_ptr<Expr> expression"},
-    {"Var", "shared_ptr<Token> name, shared_ptr<Expr> initializer"},
-    {"Block", "vector<shared_ptr<Stmt>> statements"},
-    {"If", "shared_ptr<Expr> condition, shared_ptr<Stmt> thenBranch, shared_ptr<Stmt> elseBranch"},
-    {"While", "shared_ptr<Expr> condition, shared_ptr<Stmt> body"},
-    {"Function", "shared_ptr<Token> name, vector<shared_ptr<Token>> params, vector<shared_ptr<Stmt>> body"},
-    {"Return", "shared_ptr<Token> keyword, shared_ptr<Expr> value"},
-    {"Class", "shared_ptr<Token> name, shared_ptr<Variable> superclass, vector<shared_ptr<Function>> methods"},
+    {"Expression", "Expr* expression"},
+    {"Print", "Expr* expression"},
+    {"Var", "Token* name, Expr* initializer"},
+    {"Block", "vector<Stmt*> statements"},
+    {"If", "Expr* condition, Stmt* thenBranch, Stmt* elseBranch"},
+    {"While", "Expr* condition, Stmt* body"},
+    {"Function", "Token* name, vector<Token*> params, vector<Stmt*> body"},
+    {"Return", "Token* keyword, Expr* value"},
+    {"Class", "Token* name, Variable* superclass, vector<Function*> methods"},
 };
 
-const static vector<string> exprVisitorTypes = {"string", "shared_ptr<Value>", "void"};
+// runtime state cached on the node itself, not initialized by the constructor. "= value" gives a default to fields
+// of types that have none of their own.
+const static map<string, string> exprMutableFields = {
+    {"Assign", "Slot slot, GlobalSite global"},
+    {"Get", "PropertySite site"},
+    {"Literal", "StringSite site"},
+    {"Set", "PropertySite site"},
+    {"Super", "Slot slot, Slot receiver, int target = -1"},
+    {"This", "Slot slot"},
+    {"Variable", "Slot slot, GlobalSite global"},
+};
+
+const static map<string, string> stmtMutableFields = {
+    {"Class", "Slot slot, Slot superSlot, vector<Token*> superMethods"},
+    {"Function", "Slot slot, FrameLayout frame"},
+    {"Var", "Slot slot"},
+};
 
-const static vector<string> stmtVisitorTypes = {"string", "void"};
+const static vector<string> exprVisitorTypes = {"string", "Value", "void"};
+
+const static vector<string> stmtVisitorTypes = {"string", "void", "Completion"};
 
 vector<string> split(string str, char del)
 {
@@ -100,14 +123,17 @@ string defineVisitor(const string &baseName, const map<string, string> &types)
     return ss.str();
 }
 
+// pointers to arena allocated nodes are passed by value, everything else by const reference
 string toConstRefArg(string &fieldEntry)
 {
     fieldEntry.erase(0, fieldEntry.find_first_not_of(' '));
+    if (regex_search(fieldEntry, regex("\\* ")))
+        return fieldEntry;
     string ref = regex_replace(fieldEntry, regex(" "), " &");
     return "const " + ref;
 }
 
-void defineAst(const string &baseName, const map<string, string> &types)
+void defineAst(const string &baseName, const map<string, string> &types, const map<string, string> &mutableTypes)
 {
     stringstream ss;
 
@@ -166,6 +192,17 @@ void defineAst(const string &baseName, const map<string, string> &types)
 
             ss << type << " " << member << ";";
         }
+        if (mutableTypes.contains(className))
+        {
+            for (auto field : split(mutableTypes.at(className), ','))
+            {
+                auto typeAndVarname = split(field, ' ');
+                ss << "mutable " << typeAndVarname[0] << " " << toMember(typeAndVarname[1]);
+                if (typeAndVarname.size() == 4)
+                    ss << " = " << typeAndVarname[3];
+                ss << ";";
+            }
+        }
         ss << endl;
 
         // accept for visitor
@@ -217,14 +254,13 @@ int main(int argc, char const *argv[])
     cout << "namespace lox";
     cout << " { ";
     cout << endl << endl;
-    cout << "using std::shared_ptr;";
     cout << "using std::vector;";
     cout << endl << endl;
 
     if (IsStmt(argc, argv))
-        defineAst("Stmt", stmts);
+        defineAst("Stmt", stmts, stmtMutableFields);
     else
-        defineAst("Expr", exprs);
+        defineAst("Expr", exprs, exprMutableFields);
 
     cout << " };";
 